@@ -0,0 +1,147 @@
+// Pool allocator vs malloc/free for fixed-size objects, with churn similar to spawning and despawning
+// projectiles, pickups and particles.
+//
+//   make bench-pool [ARGS="<n_objects> <n_rounds>"]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "arena.h"
+#include "pool.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_N_OBJECTS 10000
+#define DEFAULT_N_ROUNDS 1000
+
+// Roughly an entity's worth of data
+typedef struct {
+    f32 x, y, vx, vy;
+    f32 ttl;
+    u32 kind;
+    u64 flags;
+} Object;
+
+static f64 now_secs(void);
+static void report(const char* name, const f64 elapsed, const f64 n_ops, const f64 checksum);
+static f64 bench_pool(const u32 n, const u32 n_rounds);
+static f64 bench_malloc(const u32 n, const u32 n_rounds);
+
+int main(int argc, char** argv)
+{
+    u32 n = argc > 1 ? (u32)strtoul(argv[1], NULL, 10) : DEFAULT_N_OBJECTS;
+    u32 n_rounds = argc > 2 ? (u32)strtoul(argv[2], NULL, 10) : DEFAULT_N_ROUNDS;
+
+    util_info("%u objects of %zu bytes, %u rounds of free-half/realloc-half", n, sizeof(Object), n_rounds);
+
+    f64 m = bench_malloc(n, n_rounds);
+    f64 p = bench_pool(n, n_rounds);
+    util_info("speedup: x%.2f", m / p);
+
+    return EXIT_SUCCESS;
+}
+
+// ································································································
+
+static f64 now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, const f64 elapsed, const f64 n_ops, const f64 checksum)
+{
+    util_info("%-6s %8.3f ms %6.2f ns/op (checksum %.1f)", name, elapsed * 1000.0, elapsed * 1e9 / n_ops, checksum);
+}
+
+static f64 bench_pool(const u32 n, const u32 n_rounds)
+{
+    MemoryArena arena;
+    arena_init_virtual(&arena, 1 * GB);
+
+    Pool pool;
+    if (!pool_init_typed(&pool, &arena, Object, n)) {
+        util_fatal("Failed to init pool");
+    }
+
+    f64 checksum = 0.0;
+    f64 start = now_secs();
+
+    for (u32 i = 0; i < n; ++i) {
+        Object* o = (Object*)pool_alloc(&pool, NULL);
+        *o = (Object){.x = (f32)i, .ttl = 1.0f};
+    }
+
+    for (u32 r = 0; r < n_rounds; ++r) {
+        // Despawn every other live object, then respawn back up to capacity
+        for (u32 i = pool.count; i-- > 0;) {
+            if ((i + r) % 2) {
+                pool_free(&pool, pool_handle_at(&pool, i));
+            }
+        }
+        while (pool.count < n) {
+            Object* o = (Object*)pool_alloc(&pool, NULL);
+            *o = (Object){.x = (f32)r, .ttl = 1.0f};
+        }
+
+        // Dense iteration over live objects
+        for (u32 i = 0; i < pool.count; ++i) {
+            Object* o = (Object*)pool_at(&pool, i);
+            o->ttl -= 0.01f;
+            checksum += (f64)o->x;
+        }
+    }
+
+    f64 elapsed = now_secs() - start;
+    report("pool", elapsed, (f64)n_rounds * n, checksum);
+
+    arena_free(&arena);
+    return elapsed;
+}
+
+static f64 bench_malloc(const u32 n, const u32 n_rounds)
+{
+    Object** live = (Object**)malloc(sizeof(Object*) * n);
+    if (!live) {
+        util_fatal("Failed to allocate live list");
+    }
+    u32 count = 0;
+
+    f64 checksum = 0.0;
+    f64 start = now_secs();
+
+    for (u32 i = 0; i < n; ++i) {
+        Object* o = (Object*)malloc(sizeof(Object));
+        *o = (Object){.x = (f32)i, .ttl = 1.0f};
+        live[count++] = o;
+    }
+
+    for (u32 r = 0; r < n_rounds; ++r) {
+        for (u32 i = count; i-- > 0;) {
+            if ((i + r) % 2) {
+                free(live[i]);
+                live[i] = live[--count];
+            }
+        }
+        while (count < n) {
+            Object* o = (Object*)malloc(sizeof(Object));
+            *o = (Object){.x = (f32)r, .ttl = 1.0f};
+            live[count++] = o;
+        }
+
+        for (u32 i = 0; i < count; ++i) {
+            live[i]->ttl -= 0.01f;
+            checksum += (f64)live[i]->x;
+        }
+    }
+
+    f64 elapsed = now_secs() - start;
+    report("malloc", elapsed, (f64)n_rounds * n, checksum);
+
+    for (u32 i = 0; i < count; ++i) {
+        free(live[i]);
+    }
+    free(live);
+    return elapsed;
+}
@@ -0,0 +1,119 @@
+// Scalar vs SIMD throughput of the projectile integration kernels.
+//
+//   make bench-projectiles [ARGS="<n_projectiles> <n_steps>"]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "projectile_kernel.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_N_PROJECTILES 10000
+#define DEFAULT_N_STEPS 1000
+#define BENCH_DT (1.0f / 120.0f)
+
+typedef void (*integrate_fn)(ProjectileSoA* p, const f32 dt);
+
+static f64 now_secs(void);
+static bool soa_alloc(ProjectileSoA* p, const u32 cap);
+static void soa_seed(ProjectileSoA* p);
+static void soa_free(ProjectileSoA* p);
+static f64 run(const char* name, integrate_fn fn, ProjectileSoA* p, const u32 n_steps);
+
+int main(int argc, char** argv)
+{
+    u32 n = argc > 1 ? (u32)strtoul(argv[1], NULL, 10) : DEFAULT_N_PROJECTILES;
+    u32 n_steps = argc > 2 ? (u32)strtoul(argv[2], NULL, 10) : DEFAULT_N_STEPS;
+
+    ProjectileSoA p;
+    if (!soa_alloc(&p, n)) {
+        util_fatal("Failed to allocate %u projectiles", n);
+    }
+    p.count = n;
+
+    util_info("%u projectiles, %u steps, SIMD width %d", n, n_steps, PROJECTILE_SIMD_WIDTH);
+
+    f64 scalar = run("scalar", projectile_integrate_scalar, &p, n_steps);
+    f64 simd = run("simd", projectile_integrate_simd, &p, n_steps);
+    util_info("speedup: x%.2f", scalar / simd);
+
+    soa_free(&p);
+
+    return EXIT_SUCCESS;
+}
+
+// ································································································
+
+static f64 now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+static bool soa_alloc(ProjectileSoA* p, const u32 cap)
+{
+    *p = (ProjectileSoA){.cap = cap};
+
+    size_t bytes = sizeof(f32) * projectile_padded_cap(cap);
+    f32** lanes[] = {&p->x, &p->y, &p->prev_x, &p->prev_y, &p->vx, &p->vy, &p->gravity, &p->ttl};
+    for (size_t i = 0; i < sizeof(lanes) / sizeof(lanes[0]); ++i) {
+        *lanes[i] = (f32*)aligned_alloc(PROJECTILE_ALIGN, bytes);
+        if (!*lanes[i]) {
+            return false;
+        }
+        memset(*lanes[i], 0, bytes);
+    }
+
+    return true;
+}
+
+static void soa_seed(ProjectileSoA* p)
+{
+    srand(42);
+    for (u32 i = 0; i < p->cap; ++i) {
+        p->x[i] = (f32)(rand() % 1440);
+        p->y[i] = (f32)(rand() % 900);
+        p->vx[i] = (f32)(rand() % 200) - 100.0f;
+        p->vy[i] = (f32)(rand() % 200) - 150.0f;
+        p->gravity[i] = (i % 2) ? 600.0f : 0.0f;
+        p->ttl[i] = 3.0f;
+    }
+}
+
+static void soa_free(ProjectileSoA* p)
+{
+    free(p->x);
+    free(p->y);
+    free(p->prev_x);
+    free(p->prev_y);
+    free(p->vx);
+    free(p->vy);
+    free(p->gravity);
+    free(p->ttl);
+}
+
+static f64 run(const char* name, integrate_fn fn, ProjectileSoA* p, const u32 n_steps)
+{
+    soa_seed(p);
+
+    f64 start = now_secs();
+    for (u32 i = 0; i < n_steps; ++i) {
+        fn(p, BENCH_DT);
+    }
+    f64 elapsed = now_secs() - start;
+
+    // Fold the results into a checksum so the work can't be optimised away
+    f64 checksum = 0.0;
+    for (u32 i = 0; i < p->count; ++i) {
+        checksum += (f64)p->x[i] + (f64)p->y[i];
+    }
+
+    f64 per_step_ms = elapsed * 1000.0 / n_steps;
+    f64 ns_per_projectile = elapsed * 1e9 / ((f64)n_steps * p->count);
+    util_info("%-6s %8.4f ms/step %6.3f ns/projectile (checksum %.1f)", name, per_step_ms, ns_per_projectile, checksum);
+
+    return elapsed;
+}
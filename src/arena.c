@@ -0,0 +1,97 @@
+// Kept out of arena.h so the platform headers don't leak into files that include raylib.
+#define _DEFAULT_SOURCE
+
+#include "arena.h"
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Reserves address space without backing it with memory.
+void* arena_os_reserve(size_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#endif
+}
+
+// Makes a reserved range readable and writable. Pages are only backed once touched.
+bool arena_os_commit(void* ptr, size_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+// Drops the physical pages behind a committed range; the range stays usable.
+void arena_os_discard(void* ptr, size_t size)
+{
+#ifdef _WIN32
+    VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE);
+#else
+    madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
+void arena_os_release(void* ptr, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+// Writes the arena's usage and per-tag breakdown in a human readable form.
+void arena_dump_stats(const MemoryArena* arena, const char* name, FILE* f)
+{
+    fprintf(f, "%s: offset=%zu committed=%zu cap=%zu\n", name, arena->offset, arena->committed, arena->cap);
+#if ARENA_STATS
+    const ArenaStats* st = &arena->stats;
+    fprintf(f,
+            "  allocs=%u requested=%zu padding=%zu peak=%zu\n",
+            st->n_allocs,
+            st->bytes_requested,
+            st->bytes_padding,
+            st->peak);
+    for (u32 i = 0; i < st->n_tags; ++i) {
+        fprintf(f, "  %-32s allocs=%-6u bytes=%zu\n", st->tags[i].tag, st->tags[i].n_allocs, st->tags[i].bytes);
+    }
+#endif
+}
+
+// Formats into a NUL-terminated string allocated from the arena. Meant for the per-frame arena, where
+// the string lives until the next frame without needing to be freed.
+char* arena_printf(MemoryArena* arena, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        return NULL;
+    }
+
+    char* str = (char*)arena_alloc_tagged(arena, (size_t)len + 1, 1, "Strings");
+    if (!str) {
+        return NULL;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(str, (size_t)len + 1, fmt, ap);
+    va_end(ap);
+
+    return str;
+}
@@ -2,27 +2,124 @@
 #define ARENA_H_
 
 #include "utils.h"
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define MB (1024 * 1024)
+#define GB (1024 * MB)
+
+// Set ARENA_STATS to 0 to compile out allocation tracking.
+#ifndef ARENA_STATS
+#define ARENA_STATS 1
+#endif
+#define ARENA_MAX_TAGS 16
+
+#define ARENA_STRINGIFY_(x) #x
+#define ARENA_STRINGIFY(x) ARENA_STRINGIFY_(x)
+#define ARENA_CALL_SITE (__FILE__ ":" ARENA_STRINGIFY(__LINE__))
+
+// Allocations that don't name a tag are tagged with their call site.
+#define arena_alloc_aligned(arena, size, align) arena_alloc_tagged((arena), (size), (align), ARENA_CALL_SITE)
+
+// Virtual arenas commit memory in steps of this size as the offset grows.
+#define ARENA_COMMIT_GRANULARITY (64 * 1024)
+
+typedef struct {
+    const char* tag;
+    u32 n_allocs;
+    size_t bytes;
+} ArenaTagStats;
+
+// Counters are cumulative since init; markers and resets don't rewind them.
+typedef struct {
+    u32 n_allocs;
+    size_t bytes_requested;
+    size_t bytes_padding; // Lost to alignment
+    size_t peak;          // Highest offset reached
+    u32 n_tags;
+    ArenaTagStats tags[ARENA_MAX_TAGS];
+} ArenaStats;
 
 typedef struct {
     unsigned char* base; // The start of the arena
     size_t cap;
     size_t offset;
+    size_t committed; // Bytes backed by memory; only differs from cap for virtual arenas
+    bool is_virtual;
+#if ARENA_STATS
+    ArenaStats stats;
+#endif
 } MemoryArena;
 
 typedef size_t ArenaMarker;
 
+// A temporary sub-scope of an arena; everything allocated inside it is released by arena_temp_end.
+typedef struct {
+    MemoryArena* arena;
+    ArenaMarker marker;
+} ArenaTemp;
+
+// Page level OS primitives backing virtual arenas, see arena.c.
+void* arena_os_reserve(size_t size);
+bool arena_os_commit(void* ptr, size_t size);
+void arena_os_discard(void* ptr, size_t size);
+void arena_os_release(void* ptr, size_t size);
+
+void arena_dump_stats(const MemoryArena* arena, const char* name, FILE* f);
+#ifdef __linux__
+__attribute__((format(printf, 2, 3))) char* arena_printf(MemoryArena* arena, const char* fmt, ...);
+#else
+char* arena_printf(MemoryArena* arena, const char* fmt, ...);
+#endif
+
 static inline void arena_init(MemoryArena* arena, size_t cap)
 {
+    *arena = (MemoryArena){0};
     arena->base = (unsigned char*)malloc(cap * sizeof(unsigned char));
     if (!arena->base) {
         util_error("Failed to malloc arena");
     }
     arena->cap = cap;
     arena->offset = 0;
+    arena->committed = cap;
+    arena->is_virtual = false;
+}
+
+// Reserves an address range of cap bytes without backing it, so the arena can grow to cap while only
+// paying for the pages it actually touches.
+static inline void arena_init_virtual(MemoryArena* arena, size_t cap)
+{
+    *arena = (MemoryArena){0};
+
+    arena->base = (unsigned char*)arena_os_reserve(cap);
+    if (!arena->base) {
+        util_error("Failed to reserve arena: cap=%zu", cap);
+        return;
+    }
+
+    arena->cap = cap;
+    arena->is_virtual = true;
+}
+
+// Commits enough pages for the arena to hold end bytes.
+static inline bool arena_commit(MemoryArena* arena, size_t end)
+{
+    size_t new_committed = (end + ARENA_COMMIT_GRANULARITY - 1) & ~(size_t)(ARENA_COMMIT_GRANULARITY - 1);
+    if (new_committed > arena->cap) new_committed = arena->cap;
+
+    unsigned char* start = arena->base + arena->committed;
+    size_t len = new_committed - arena->committed;
+
+    if (!arena_os_commit(start, len)) {
+        util_error("Failed to commit arena memory: size=%zu, committed=%zu", len, arena->committed);
+        return false;
+    }
+
+    arena->committed = new_committed;
+    return true;
 }
 
 static inline size_t align_forward(size_t ptr, size_t align)
@@ -32,15 +129,51 @@ static inline size_t align_forward(size_t ptr, size_t align)
     return ptr;
 }
 
-static inline void* arena_alloc_aligned(MemoryArena* arena, size_t size, size_t align)
+#if ARENA_STATS
+static inline void arena_track(MemoryArena* arena, size_t size, size_t padding, const char* tag)
+{
+    ArenaStats* st = &arena->stats;
+    st->n_allocs++;
+    st->bytes_requested += size;
+    st->bytes_padding += padding;
+    if (arena->offset > st->peak) st->peak = arena->offset;
+
+    ArenaTagStats* ts = NULL;
+    for (u32 i = 0; i < st->n_tags; ++i) {
+        if (st->tags[i].tag == tag || strcmp(st->tags[i].tag, tag) == 0) {
+            ts = &st->tags[i];
+            break;
+        }
+    }
+    if (!ts) {
+        // Once the table is full, everything else is lumped into the last slot
+        ts = st->n_tags < ARENA_MAX_TAGS ? &st->tags[st->n_tags++] : &st->tags[ARENA_MAX_TAGS - 1];
+        if (!ts->tag) ts->tag = tag;
+    }
+    ts->n_allocs++;
+    ts->bytes += size;
+}
+#endif
+
+static inline void* arena_alloc_tagged(MemoryArena* arena, size_t size, size_t align, const char* tag)
 {
     size_t aligned_offset = align_forward(arena->offset, align);
     if (aligned_offset + size > arena->cap) {
         util_error("No space left in arena: size=%zu, cap=%zu, offset=%zu", size, arena->cap, aligned_offset);
         return NULL;
     }
+    if (aligned_offset + size > arena->committed && !arena_commit(arena, aligned_offset + size)) {
+        return NULL;
+    }
     void* ptr = arena->base + aligned_offset;
+#if ARENA_STATS
+    size_t padding = aligned_offset - arena->offset;
+    arena->offset = aligned_offset + size;
+    arena_track(arena, size, padding, tag);
+#else
+    (void)tag;
     arena->offset = aligned_offset + size;
+#endif
     return ptr;
 }
 
@@ -54,16 +187,41 @@ static inline void arena_set_marker(MemoryArena* arena, ArenaMarker marker)
     arena->offset = marker;
 }
 
+static inline ArenaTemp arena_temp_begin(MemoryArena* arena)
+{
+    return (ArenaTemp){
+        .arena = arena,
+        .marker = arena_get_marker(arena),
+    };
+}
+
+static inline void arena_temp_end(ArenaTemp temp)
+{
+    arena_set_marker(temp.arena, temp.marker);
+}
+
+// Rewinds the arena. Virtual arenas also hand their physical pages back to the OS while keeping the
+// range committed.
 static inline void arena_reset(MemoryArena* arena)
 {
     arena->offset = 0;
+
+    if (arena->is_virtual && arena->committed > 0) {
+        arena_os_discard(arena->base, arena->committed);
+    }
 }
 
 static inline void arena_free(MemoryArena* arena)
 {
-    free(arena->base);
+    if (arena->is_virtual) {
+        arena_os_release(arena->base, arena->cap);
+    } else {
+        free(arena->base);
+    }
+    arena->base = NULL;
     arena->cap = 0;
     arena->offset = 0;
+    arena->committed = 0;
 }
 
 #endif // !ARENA_H_
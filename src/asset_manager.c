@@ -1,115 +1,770 @@
 #include "asset_manager.h"
 #include "arena.h"
+#include "asset_pack.h"
+#include "file_watch.h"
+#include "mapped_file.h"
+#include "thread.h"
 #include <raylib.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 static AssetManager* mgr;
 static MemoryArena* game_mem;
 
+static void worker_run(void* arg);
+static void queue_decode(const TextureHandle h);
+static void reload_changed(void);
+static bool reload_file(const char* path);
+static void open_pack(void);
+static Image load_image(const char* path);
+static Font load_font(
+    const char* path, const char* id, const i32 size, i32* codepoints, const i32 n_codepoints, const bool use_cache);
+static Font load_cached_font(const char* cache_path, const FontCacheKey* key);
+static Font bake_font(
+    const u8* data, const size_t data_size, const FontCacheKey* key, i32* codepoints, const char* cache_path);
+static void save_cached_font(const char* cache_path, const Font* font, const FontCacheKey* key, const Image atlas);
+static TextureHandle add_texture(const char* fname);
+static bool finish_texture(const TextureHandle h);
+static void upload_texture(const TextureHandle h);
+static const char* intern_id(const char* id);
+static i32* copy_codepoints(const i32* codepoints, const i32 n_codepoints);
+static u32 hash_id(const char* id);
+static u32 index_find(const AssetIndex* index, const char* id);
+static bool index_insert(AssetIndex* index, const char* id, const u32 handle);
+
 bool assetmgr_init(MemoryArena* gmem)
 {
-    mgr = (AssetManager*)arena_alloc_aligned(gmem, sizeof(AssetManager), 16);
+    mgr = (AssetManager*)arena_alloc_tagged(gmem, sizeof(AssetManager), 16, "AssetManager");
     if (!mgr) {
         util_error("Failed to allocate for asset manager");
         return false;
     }
-
-    mgr->n_textures = 0;
-    mgr->n_fonts = 0;
+    *mgr = (AssetManager){0};
 
     game_mem = gmem;
 
+    open_pack();
+
+    arena_init_virtual(&mgr->texture_mem, sizeof(TextureAsset) * ASSET_MAX_TEXTURES);
+    arena_init_virtual(&mgr->font_mem, sizeof(FontAsset) * ASSET_MAX_FONTS);
+    if (!mgr->texture_mem.base || !mgr->font_mem.base) {
+        util_error("Failed to reserve asset records");
+        return false;
+    }
+    mgr->textures = (TextureAsset*)mgr->texture_mem.base;
+    mgr->fonts = (FontAsset*)mgr->font_mem.base;
+
+    // Handle 0 of each kind is the fallback; pending textures draw as nothing rather than as garbage
+    Image blank = GenImageColor(1, 1, BLANK);
+    TextureAsset* placeholder = (TextureAsset*)arena_alloc_tagged(&mgr->texture_mem, sizeof(TextureAsset), 8, "Textures");
+    FontAsset* default_font = (FontAsset*)arena_alloc_tagged(&mgr->font_mem, sizeof(FontAsset), 8, "Fonts");
+    *placeholder = (TextureAsset){.tex = LoadTextureFromImage(blank), .id = ""};
+    *default_font = (FontAsset){.font = GetFontDefault(), .id = ""};
+    UnloadImage(blank);
+    mgr->n_textures = 1;
+    mgr->n_fonts = 1;
+
+    mutex_init(&mgr->lock);
+    cond_init(&mgr->wake);
+    cond_init(&mgr->decoded);
+    if (!thread_start(&mgr->worker, worker_run, NULL)) {
+        util_error("Failed to start asset loader thread");
+        return false;
+    }
+
     return true;
 }
 
-Texture2D* assetmgr_load_texture(const char* fname)
+// Starts reloading assets whenever their files under dirs are written. Meant for development, so it's
+// refused while loading from a pack, which the loose files wouldn't be read over.
+bool assetmgr_watch(const char** dirs, const u32 n_dirs)
 {
-    if (mgr->n_textures >= MAX_TEXTURES) {
-        util_error("Asset manager has no more space for textures");
-        return NULL;
+    if (mgr->pack.data) {
+        util_warn("Hot reloading is off while loading assets from %s", mgr->pack_path);
+        return false;
     }
 
-    // Check if texture already exisits
-    for (size_t i = 0; i < mgr->n_textures; ++i) {
-        if (strncmp(mgr->texture_ids[i], fname, strlen(fname)) == 0) {
-            return &mgr->textures[i];
+    mgr->watching = file_watch_start(&mgr->watch, dirs, n_dirs);
+    return mgr->watching;
+}
+
+// Picks up changed files and uploads decoded textures until ASSET_UPLOAD_BUDGET is spent. Call once per
+// frame.
+void assetmgr_update(void)
+{
+    if (mgr->watching) {
+        reload_changed();
+    }
+
+    size_t uploaded = 0;
+
+    for (TextureHandle h = 1; h < mgr->n_textures && (uploaded == 0 || uploaded < ASSET_UPLOAD_BUDGET); ++h) {
+        mutex_lock(&mgr->lock);
+        bool decoded = mgr->textures[h].status == ASSET_DECODED;
+        mutex_unlock(&mgr->lock);
+        if (!decoded) {
+            continue;
         }
+
+        Image* img = &mgr->textures[h].img;
+        uploaded += (size_t)GetPixelDataSize(img->width, img->height, img->format);
+        upload_texture(h);
     }
+}
 
-    mgr->textures[mgr->n_textures] = LoadTexture(fname);
-    if (!IsTextureValid(mgr->textures[mgr->n_textures])) {
+// Loads a texture, blocking until it's on the GPU. Finishes any async load of the same file first.
+// Returns ASSET_NONE on failure.
+TextureHandle assetmgr_load_texture(const char* fname)
+{
+    TextureHandle h = assetmgr_find_texture(fname);
+    if (h != ASSET_NONE) {
+        return finish_texture(h) ? h : ASSET_NONE;
+    }
+
+    h = add_texture(fname);
+    if (h == ASSET_NONE) {
+        return ASSET_NONE;
+    }
+
+    TextureAsset* t = &mgr->textures[h];
+    Image img = load_image(fname);
+    Texture2D tex = IsImageValid(img) ? LoadTextureFromImage(img) : (Texture2D){0};
+    UnloadImage(img);
+    if (!IsTextureValid(tex)) {
         util_error("Failed to load texture");
-        return NULL;
+        t->status = ASSET_FAILED;
+        return ASSET_NONE;
     }
+    t->tex = tex;
+    t->version++;
 
-    size_t fnamelen = strlen(fname);
-    char* texid = (char*)arena_alloc_aligned(game_mem, fnamelen, 16);
-    strncpy(texid, fname, fnamelen);
+    return h;
+}
+
+// Queues a texture for decoding on the worker thread and returns straight away. The texture reads as the
+// placeholder until assetmgr_update has uploaded it.
+TextureHandle assetmgr_load_texture_async(const char* fname)
+{
+    TextureHandle h = assetmgr_find_texture(fname);
+    if (h != ASSET_NONE) {
+        return h;
+    }
+
+    h = add_texture(fname);
+    if (h == ASSET_NONE) {
+        return ASSET_NONE;
+    }
+
+    queue_decode(h);
 
-    mgr->texture_ids[mgr->n_textures] = texid;
-    mgr->n_textures++;
+    return h;
+}
 
-    return &mgr->textures[mgr->n_textures - 1];
+TextureHandle assetmgr_find_texture(const char* id)
+{
+    return index_find(&mgr->texture_index, id);
 }
 
-Texture2D* assetmgr_get_texture(const char* id)
+Texture2D* assetmgr_get_texture(const TextureHandle h)
 {
-    for (size_t i = 0; i < mgr->n_textures; ++i) {
-        if (strncmp(mgr->texture_ids[i], id, strlen(id)) == 0) {
-            return &mgr->textures[i];
+    return &mgr->textures[h < mgr->n_textures ? h : ASSET_NONE].tex;
+}
+
+u32 assetmgr_get_texture_version(const TextureHandle h)
+{
+    return mgr->textures[h < mgr->n_textures ? h : ASSET_NONE].version;
+}
+
+// True while textures are being decoded or wait for their upload, or changed files wait to be reloaded.
+// Either finishes in assetmgr_update, so the caller should keep running frames until this clears.
+bool assetmgr_is_busy(void)
+{
+    if (mgr->watching) {
+        mutex_lock(&mgr->watch.lock);
+        u32 n_changed = mgr->watch.n_changed;
+        mutex_unlock(&mgr->watch.lock);
+        if (n_changed > 0) {
+            return true;
         }
     }
-    return NULL;
+
+    bool busy = false;
+    mutex_lock(&mgr->lock);
+    for (TextureHandle h = 1; h < mgr->n_textures && !busy; ++h) {
+        busy = mgr->textures[h].status == ASSET_DECODING || mgr->textures[h].status == ASSET_DECODED;
+    }
+    mutex_unlock(&mgr->lock);
+    return busy;
 }
 
-Font* assetmgr_load_font(const char* fname, const char* id)
+// Loads a font rasterized at size with just the glyphs for codepoints, or printable ASCII if codepoints is
+// NULL, and registers it under id. Returns ASSET_NONE on failure.
+FontHandle assetmgr_load_font(const char* fname, const char* id, const i32 size, i32* codepoints, const i32 n_codepoints)
 {
-    if (mgr->n_fonts >= MAX_FONTS) {
+    FontHandle h = assetmgr_find_font(id);
+    if (h != ASSET_NONE) {
+        return h;
+    }
+
+    ArenaMarker marker = arena_get_marker(&mgr->font_mem);
+    FontAsset* f = (FontAsset*)arena_alloc_tagged(&mgr->font_mem, sizeof(FontAsset), 8, "Fonts");
+    if (!f) {
         util_error("Asset manager has no more space for fonts");
-        return NULL;
+        return ASSET_NONE;
     }
 
-    // Check if font already exisits
-    for (size_t i = 0; i < mgr->n_fonts; ++i) {
-        if (strncmp(mgr->font_ids[i], id, strlen(id)) == 0) {
-            return &mgr->fonts[i];
+    *f = (FontAsset){
+        .font = load_font(fname, id, size, codepoints, n_codepoints, true),
+        .id = intern_id(id),
+        .path = intern_id(fname),
+        .codepoints = copy_codepoints(codepoints, n_codepoints),
+        .n_codepoints = n_codepoints,
+        .size = size,
+    };
+    if (!IsFontValid(f->font) || !f->id || !f->path || (codepoints && !f->codepoints) ||
+        !index_insert(&mgr->font_index, f->id, mgr->n_fonts)) {
+        util_error("Failed to load font");
+        if (IsFontValid(f->font)) {
+            UnloadFont(f->font);
         }
+        arena_set_marker(&mgr->font_mem, marker);
+        return ASSET_NONE;
     }
 
-    mgr->fonts[mgr->n_fonts] = LoadFont(fname);
-    if (!IsFontValid(mgr->fonts[mgr->n_fonts])) {
-        util_error("Failed to load font");
+    return mgr->n_fonts++;
+}
+
+FontHandle assetmgr_find_font(const char* id)
+{
+    return index_find(&mgr->font_index, id);
+}
+
+Font* assetmgr_get_font(const FontHandle h)
+{
+    return &mgr->fonts[h < mgr->n_fonts ? h : ASSET_NONE].font;
+}
+
+void assetmgr_destroy(void)
+{
+    if (mgr->watching) {
+        file_watch_stop(&mgr->watch);
+    }
+
+    mutex_lock(&mgr->lock);
+    mgr->quit = true;
+    cond_signal(&mgr->wake);
+    mutex_unlock(&mgr->lock);
+    thread_join(&mgr->worker);
+
+    cond_destroy(&mgr->decoded);
+    cond_destroy(&mgr->wake);
+    mutex_destroy(&mgr->lock);
+
+    for (TextureHandle h = 0; h < mgr->n_textures; ++h) {
+        // Anything that never got a texture of its own still holds the placeholder's
+        TextureAsset* t = &mgr->textures[h];
+        if (h == ASSET_NONE || t->version > 0) {
+            UnloadTexture(t->tex);
+        }
+        if (t->status == ASSET_DECODED) {
+            UnloadImage(t->img);
+        }
+    }
+
+    // The default font belongs to raylib
+    for (FontHandle h = 1; h < mgr->n_fonts; ++h) {
+        UnloadFont(mgr->fonts[h].font);
+    }
+
+    arena_free(&mgr->texture_mem);
+    arena_free(&mgr->font_mem);
+    mapped_file_close(&mgr->pack);
+}
+
+// ································································································
+
+static void worker_run(void* arg)
+{
+    (void)arg;
+
+    mutex_lock(&mgr->lock);
+    while (true) {
+        while (!mgr->quit && mgr->queue_head == 0) {
+            cond_wait(&mgr->wake, &mgr->lock);
+        }
+        if (mgr->quit) {
+            break;
+        }
+
+        TextureAsset* t = &mgr->textures[mgr->queue_head];
+        mgr->queue_head = t->next_queued;
+        if (mgr->queue_head == 0) {
+            mgr->queue_tail = 0;
+        }
+        const char* fname = t->id;
+        mutex_unlock(&mgr->lock);
+
+        // File IO and PNG decoding only; anything touching the GPU stays on the main thread
+        Image img = load_image(fname);
+
+        mutex_lock(&mgr->lock);
+        t->img = img;
+        if (IsImageValid(img)) {
+            t->status = ASSET_DECODED;
+        } else {
+            // A failed reload leaves the previous version in place
+            t->status = t->version > 0 ? ASSET_READY : ASSET_FAILED;
+            util_error("Failed to decode texture: %s", fname);
+        }
+        cond_broadcast(&mgr->decoded);
+    }
+    mutex_unlock(&mgr->lock);
+}
+
+static void queue_decode(const TextureHandle h)
+{
+    mutex_lock(&mgr->lock);
+    mgr->textures[h].status = ASSET_DECODING;
+    mgr->textures[h].next_queued = 0;
+    if (mgr->queue_tail != 0) {
+        mgr->textures[mgr->queue_tail].next_queued = h;
+    } else {
+        mgr->queue_head = h;
+    }
+    mgr->queue_tail = h;
+    cond_signal(&mgr->wake);
+    mutex_unlock(&mgr->lock);
+}
+
+static void reload_changed(void)
+{
+    char paths[FILE_WATCH_MAX_CHANGES][FILE_WATCH_MAX_PATH];
+    u32 n = file_watch_poll(&mgr->watch, paths, FILE_WATCH_MAX_CHANGES);
+
+    u32 n_retry = 0;
+    for (u32 i = 0; i < n; ++i) {
+        if (!reload_file(paths[i])) {
+            memcpy(paths[n_retry++], paths[i], FILE_WATCH_MAX_PATH);
+        }
+    }
+
+    // Re-mark anything that couldn't be reloaded yet, so it's picked up on a later frame
+    mutex_lock(&mgr->watch.lock);
+    for (u32 i = 0; i < n_retry && mgr->watch.n_changed < FILE_WATCH_MAX_CHANGES; ++i) {
+        memcpy(mgr->watch.changed[mgr->watch.n_changed++], paths[i], FILE_WATCH_MAX_PATH);
+    }
+    mutex_unlock(&mgr->watch.lock);
+}
+
+// Reloads whichever textures and fonts came from path. Files that aren't loaded assets are ignored.
+// Returns false if path has to wait for a load that's already in flight.
+static bool reload_file(const char* path)
+{
+    TextureHandle th = assetmgr_find_texture(path);
+    if (th != ASSET_NONE) {
+        mutex_lock(&mgr->lock);
+        u8 status = mgr->textures[th].status;
+        mutex_unlock(&mgr->lock);
+        if (status == ASSET_DECODING || status == ASSET_DECODED) {
+            return false;
+        }
+
+        util_info("Reloading %s", path);
+        queue_decode(th);
+    }
+
+    // Fonts are rasterized here and now. The cache is skipped, as mtimes only have second resolution.
+    for (FontHandle h = 1; h < mgr->n_fonts; ++h) {
+        FontAsset* f = &mgr->fonts[h];
+        if (strcmp(f->path, path) != 0) {
+            continue;
+        }
+
+        util_info("Reloading %s", path);
+        Font font = load_font(f->path, f->id, f->size, f->codepoints, f->n_codepoints, false);
+        if (!IsFontValid(font)) {
+            util_error("Failed to reload font: %s", path);
+            continue;
+        }
+        UnloadFont(f->font);
+        f->font = font;
+    }
+
+    return true;
+}
+
+// The pack is built into the executable's directory, which isn't where the game runs from with make run
+static void open_pack(void)
+{
+    snprintf(mgr->pack_path, sizeof(mgr->pack_path), "%s%s", GetApplicationDirectory(), ASSET_PACK_PATH);
+    if (!mapped_file_open(&mgr->pack, mgr->pack_path)) {
+        snprintf(mgr->pack_path, sizeof(mgr->pack_path), "%s", ASSET_PACK_PATH);
+        if (!mapped_file_open(&mgr->pack, mgr->pack_path)) {
+            return;
+        }
+    }
+
+    if (!asset_pack_validate(mgr->pack.data, mgr->pack.size)) {
+        util_warn("Ignoring invalid asset pack: %s", mgr->pack_path);
+        mapped_file_close(&mgr->pack);
+        return;
+    }
+
+    util_info("Loading assets from %s", mgr->pack_path);
+}
+
+// Decodes an image from the pack, falling back to the file on disk. Safe to call from the worker, as the
+// pack is never written to after init.
+static Image load_image(const char* path)
+{
+    const AssetPackEntry* e = mgr->pack.data ? asset_pack_find(mgr->pack.data, path) : NULL;
+    if (!e) {
+        return LoadImage(path);
+    }
+
+    return LoadImageFromMemory(GetFileExtension(path), mgr->pack.data + e->offset, (int)e->size);
+}
+
+// Uses the cached atlas if there's an up to date one, otherwise rasterizes the TTF and caches the result.
+static Font load_font(
+    const char* path, const char* id, const i32 size, i32* codepoints, const i32 n_codepoints, const bool use_cache)
+{
+    const AssetPackEntry* e = mgr->pack.data ? asset_pack_find(mgr->pack.data, path) : NULL;
+
+    FontCacheKey key = {
+        .magic = ASSET_FONT_CACHE_MAGIC,
+        .version = ASSET_FONT_CACHE_VERSION,
+        .size = size,
+        .glyph_padding = ASSET_FONT_GLYPH_PADDING,
+        .n_glyphs = codepoints ? n_codepoints : ASSET_FONT_DEFAULT_GLYPHS,
+        .codepoint_hash = 2166136261U,
+        .source_size = e ? (i64)e->size : (i64)GetFileLength(path),
+        .source_mtime = (i64)GetFileModTime(e ? mgr->pack_path : path),
+    };
+    for (i32 i = 0; codepoints && i < n_codepoints; ++i) {
+        key.codepoint_hash = (key.codepoint_hash ^ (u32)codepoints[i]) * 16777619U;
+    }
+
+    const char* cache_path = TextFormat("%s/%s-%d.font", ASSET_FONT_CACHE_DIR, id, size);
+    Font font = use_cache ? load_cached_font(cache_path, &key) : (Font){0};
+    if (IsFontValid(font)) {
+        return font;
+    }
+
+    if (e) {
+        font = bake_font(mgr->pack.data + e->offset, e->size, &key, codepoints, cache_path);
+    } else {
+        int data_size = 0;
+        u8* data = LoadFileData(path, &data_size);
+        if (!data) {
+            return (Font){0};
+        }
+        font = bake_font(data, (size_t)data_size, &key, codepoints, cache_path);
+        UnloadFileData(data);
+    }
+
+    return font;
+}
+
+// Reads a cached atlas straight into a font, without touching the TTF. Returns an invalid font if there's no
+// cache file or it was baked from something else.
+static Font load_cached_font(const char* cache_path, const FontCacheKey* key)
+{
+    int file_size = 0;
+    u8* data = FileExists(cache_path) ? LoadFileData(cache_path, &file_size) : NULL;
+    if (!data) {
+        return (Font){0};
+    }
+
+    FontCacheHeader header = {0};
+    size_t glyphs_size = sizeof(FontCacheGlyph) * (size_t)key->n_glyphs;
+    size_t pixels_size = 0;
+    if ((size_t)file_size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+        pixels_size = (size_t)GetPixelDataSize(header.atlas_width, header.atlas_height, header.atlas_format);
+    }
+    if (memcmp(&header.key, key, sizeof(FontCacheKey)) != 0 ||
+        (size_t)file_size != sizeof(header) + glyphs_size + pixels_size) {
+        UnloadFileData(data);
+        return (Font){0};
+    }
+
+    // Allocated the way raylib allocates them, so UnloadFont can free them
+    Font font = {
+        .baseSize = key->size,
+        .glyphCount = key->n_glyphs,
+        .glyphPadding = key->glyph_padding,
+        .recs = (Rectangle*)calloc((size_t)key->n_glyphs, sizeof(Rectangle)),
+        .glyphs = (GlyphInfo*)calloc((size_t)key->n_glyphs, sizeof(GlyphInfo)),
+    };
+    if (!font.recs || !font.glyphs) {
+        free(font.recs);
+        free(font.glyphs);
+        UnloadFileData(data);
+        return (Font){0};
+    }
+
+    const FontCacheGlyph* glyphs = (const FontCacheGlyph*)(data + sizeof(header));
+    for (i32 i = 0; i < key->n_glyphs; ++i) {
+        font.glyphs[i] = (GlyphInfo){
+            .value = glyphs[i].value,
+            .offsetX = glyphs[i].offset_x,
+            .offsetY = glyphs[i].offset_y,
+            .advanceX = glyphs[i].advance_x,
+        };
+        font.recs[i] = glyphs[i].rec;
+    }
+
+    Image atlas = {
+        .data = data + sizeof(header) + glyphs_size,
+        .width = header.atlas_width,
+        .height = header.atlas_height,
+        .mipmaps = 1,
+        .format = header.atlas_format,
+    };
+    font.texture = LoadTextureFromImage(atlas);
+    UnloadFileData(data);
+
+    return font;
+}
+
+// Rasterizes the glyphs into an atlas the same way LoadFontFromMemory does, and saves it to the cache
+// before it's uploaded.
+static Font bake_font(
+    const u8* data, const size_t data_size, const FontCacheKey* key, i32* codepoints, const char* cache_path)
+{
+    GlyphInfo* glyphs = LoadFontData(data, (int)data_size, key->size, codepoints, key->n_glyphs, FONT_DEFAULT);
+    if (!glyphs) {
+        return (Font){0};
+    }
+
+    Rectangle* recs = NULL;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, key->n_glyphs, key->size, key->glyph_padding, 0);
+    if (!IsImageValid(atlas)) {
+        UnloadFontData(glyphs, key->n_glyphs);
+        free(recs);
+        return (Font){0};
+    }
+
+    // The per-glyph images are only there for ImageDrawText, which we don't use; cached fonts don't have them
+    for (i32 i = 0; i < key->n_glyphs; ++i) {
+        UnloadImage(glyphs[i].image);
+        glyphs[i].image = (Image){0};
+    }
+
+    Font font = {
+        .baseSize = key->size,
+        .glyphCount = key->n_glyphs,
+        .glyphPadding = key->glyph_padding,
+        .recs = recs,
+        .glyphs = glyphs,
+    };
+    save_cached_font(cache_path, &font, key, atlas);
+    font.texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+
+    return font;
+}
+
+// Failing to write the cache only costs the next launch a rasterization, so it's just a warning.
+static void save_cached_font(const char* cache_path, const Font* font, const FontCacheKey* key, const Image atlas)
+{
+    if (!DirectoryExists(ASSET_FONT_CACHE_DIR)) {
+        MakeDirectory(ASSET_FONT_CACHE_DIR);
+    }
+
+    FILE* f = fopen(cache_path, "wb");
+    if (!f) {
+        util_warn("Failed to open font cache for writing: %s", cache_path);
+        return;
+    }
+
+    FontCacheHeader header = {
+        .key = *key,
+        .atlas_width = atlas.width,
+        .atlas_height = atlas.height,
+        .atlas_format = atlas.format,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    for (i32 i = 0; ok && i < font->glyphCount; ++i) {
+        FontCacheGlyph g = {
+            .value = font->glyphs[i].value,
+            .offset_x = font->glyphs[i].offsetX,
+            .offset_y = font->glyphs[i].offsetY,
+            .advance_x = font->glyphs[i].advanceX,
+            .rec = font->recs[i],
+        };
+        ok = fwrite(&g, sizeof(g), 1, f) == 1;
+    }
+
+    size_t pixels_size = (size_t)GetPixelDataSize(atlas.width, atlas.height, atlas.format);
+    ok = ok && fwrite(atlas.data, 1, pixels_size, f) == pixels_size;
+
+    if (fclose(f) != 0 || !ok) {
+        util_warn("Failed to write font cache: %s", cache_path);
+        remove(cache_path);
+    }
+}
+
+// Claims a texture record holding the placeholder and registers fname as its ID. Returns ASSET_NONE if
+// there's no space.
+static TextureHandle add_texture(const char* fname)
+{
+    ArenaMarker marker = arena_get_marker(&mgr->texture_mem);
+    TextureAsset* t = (TextureAsset*)arena_alloc_tagged(&mgr->texture_mem, sizeof(TextureAsset), 8, "Textures");
+    if (!t) {
+        util_error("Asset manager has no more space for textures");
+        return ASSET_NONE;
+    }
+
+    *t = (TextureAsset){.tex = mgr->textures[ASSET_NONE].tex, .id = intern_id(fname)};
+    if (!t->id || !index_insert(&mgr->texture_index, t->id, mgr->n_textures)) {
+        arena_set_marker(&mgr->texture_mem, marker);
+        return ASSET_NONE;
+    }
+
+    return mgr->n_textures++;
+}
+
+// Waits for the worker to decode texture h and uploads it. Returns false if the texture failed to load.
+static bool finish_texture(const TextureHandle h)
+{
+    TextureAsset* t = &mgr->textures[h];
+
+    mutex_lock(&mgr->lock);
+    while (t->status == ASSET_DECODING) {
+        cond_wait(&mgr->decoded, &mgr->lock);
+    }
+    u8 status = t->status;
+    mutex_unlock(&mgr->lock);
+
+    if (status == ASSET_DECODED) {
+        upload_texture(h);
+        status = t->status;
+    }
+
+    return status == ASSET_READY;
+}
+
+static void upload_texture(const TextureHandle h)
+{
+    TextureAsset* t = &mgr->textures[h];
+
+    Texture2D tex = LoadTextureFromImage(t->img);
+    UnloadImage(t->img);
+    t->img = (Image){0};
+
+    bool ok = IsTextureValid(tex);
+    if (ok) {
+        if (t->version > 0) {
+            UnloadTexture(t->tex);
+        }
+        t->tex = tex;
+        t->version++;
+    } else {
+        util_error("Failed to upload texture: %s", t->id);
+    }
+
+    mutex_lock(&mgr->lock);
+    t->status = ok || t->version > 0 ? ASSET_READY : ASSET_FAILED;
+    mutex_unlock(&mgr->lock);
+}
+
+// Copies id into the game arena, so callers' strings don't need to outlive the asset.
+static const char* intern_id(const char* id)
+{
+    size_t len = strlen(id);
+    char* copy = (char*)arena_alloc_tagged(game_mem, len + 1, 1, "Asset IDs");
+    if (!copy) {
         return NULL;
     }
+    memcpy(copy, id, len + 1);
+
+    return copy;
+}
+
+static i32* copy_codepoints(const i32* codepoints, const i32 n_codepoints)
+{
+    if (!codepoints || n_codepoints <= 0) {
+        return NULL;
+    }
+
+    size_t size = sizeof(i32) * (size_t)n_codepoints;
+    i32* copy = (i32*)arena_alloc_tagged(game_mem, size, 4, "Asset IDs");
+    if (copy) {
+        memcpy(copy, codepoints, size);
+    }
 
-    size_t idlen = strlen(id);
-    char* fontid = (char*)arena_alloc_aligned(game_mem, idlen, 16);
-    strncpy(fontid, id, idlen);
+    return copy;
+}
 
-    mgr->font_ids[mgr->n_fonts] = fontid;
-    mgr->n_fonts++;
+// FNV-1a.
+static u32 hash_id(const char* id)
+{
+    u32 hash = 2166136261U;
+    for (const u8* p = (const u8*)id; *p; ++p) {
+        hash = (hash ^ *p) * 16777619U;
+    }
 
-    return &mgr->fonts[mgr->n_fonts - 1];
+    return hash;
 }
 
-Font* assetmgr_get_font(const char* id)
+static u32 index_find(const AssetIndex* index, const char* id)
 {
-    for (size_t i = 0; i < mgr->n_fonts; ++i) {
-        if (strncmp(mgr->font_ids[i], id, strlen(id)) == 0) {
-            return &mgr->fonts[i];
+    if (index->cap == 0) {
+        return ASSET_NONE;
+    }
+
+    u32 hash = hash_id(id);
+    for (u32 i = hash & (index->cap - 1);; i = (i + 1) & (index->cap - 1)) {
+        const AssetIndexEntry* e = &index->entries[i];
+        if (e->handle == ASSET_NONE) {
+            return ASSET_NONE;
+        }
+        if (e->hash == hash && strcmp(e->id, id) == 0) {
+            return e->handle;
         }
     }
-    return NULL;
 }
 
-void assetmgr_destroy(void)
+// Adds id, which must not already be present. The entries outgrown by a resize stay behind in the game
+// arena; with doubling, that's never more than the live table.
+static bool index_insert(AssetIndex* index, const char* id, const u32 handle)
 {
-    for (size_t i = 0; i < mgr->n_textures; ++i) {
-        UnloadTexture(mgr->textures[i]);
+    if ((index->count + 1) * 2 > index->cap) {
+        u32 cap = index->cap ? index->cap * 2 : ASSET_INDEX_MIN_CAP;
+        AssetIndexEntry* entries =
+            (AssetIndexEntry*)arena_alloc_tagged(game_mem, sizeof(AssetIndexEntry) * cap, 16, "Asset index");
+        if (!entries) {
+            util_error("Failed to grow asset index");
+            return false;
+        }
+        memset(entries, 0, sizeof(AssetIndexEntry) * cap);
+
+        AssetIndex grown = {.entries = entries, .cap = cap};
+        for (u32 i = 0; i < index->cap; ++i) {
+            const AssetIndexEntry* e = &index->entries[i];
+            if (e->handle != ASSET_NONE) {
+                u32 j = e->hash & (cap - 1);
+                while (grown.entries[j].handle != ASSET_NONE) {
+                    j = (j + 1) & (cap - 1);
+                }
+                grown.entries[j] = *e;
+                grown.count++;
+            }
+        }
+        *index = grown;
     }
 
-    for (size_t i = 0; i < mgr->n_fonts; ++i) {
-        UnloadFont(mgr->fonts[i]);
+    u32 hash = hash_id(id);
+    u32 i = hash & (index->cap - 1);
+    while (index->entries[i].handle != ASSET_NONE) {
+        i = (i + 1) & (index->cap - 1);
     }
+    index->entries[i] = (AssetIndexEntry){.id = id, .hash = hash, .handle = handle};
+    index->count++;
+
+    return true;
 }
@@ -2,26 +2,162 @@
 #define ASSET_MANAGER_H_
 
 #include "arena.h"
+#include "file_watch.h"
+#include "mapped_file.h"
+#include "thread.h"
+#include "utils.h"
 #include <raylib.h>
 #include <stdbool.h>
 
-#define MAX_TEXTURES 15
-#define MAX_FONTS 5
+// Address space reserved for asset records; only the records in use are committed.
+#define ASSET_MAX_TEXTURES 65536
+#define ASSET_MAX_FONTS 1024
 
+#define ASSET_INDEX_MIN_CAP 16
+
+// Without a codepoint list, fonts get printable ASCII like LoadFontEx gives them
+#define ASSET_FONT_DEFAULT_GLYPHS 95
+#define ASSET_FONT_GLYPH_PADDING 4
+
+// Rasterized font atlases are kept here, so later launches don't have to rasterize the TTF again
+#define ASSET_FONT_CACHE_DIR "cache/fonts"
+#define ASSET_FONT_CACHE_MAGIC 0x544E4646U // "FFNT" read as a little-endian u32
+#define ASSET_FONT_CACHE_VERSION 1
+
+// Bytes of decoded pixels uploaded to the GPU per frame; at least one texture is uploaded regardless.
+#define ASSET_UPLOAD_BUDGET (4 * MB)
+
+// Room for the asset pack's path, which starts with the executable's directory
+#define ASSET_PACK_PATH_MAX 512
+
+// Handles index the asset records directly and stay valid for the life of the asset manager. Handle 0 is
+// the placeholder texture or raylib's default font, and doubles as the "not found" result.
+typedef u32 TextureHandle;
+typedef u32 FontHandle;
+
+#define ASSET_NONE 0U
+
+typedef enum {
+    ASSET_READY = 0,
+    ASSET_DECODING, // Queued for, or being decoded by, the worker
+    ASSET_DECODED,  // Decoded into CPU memory, waiting for its upload
+    ASSET_FAILED,
+} AssetStatus;
+
+typedef struct {
+    Texture2D tex;
+    Image img;
+    const char* id;
+    u32 next_queued; // Next record in the decode queue, 0 at the tail
+    u32 version;     // Bumped every time tex is replaced, so users of tex can tell it's been reloaded
+    u8 status;       // Guarded by AssetManager.lock
+} TextureAsset;
+
+// Keeps what the font was loaded with, so it can be rasterized again when the file changes.
+typedef struct {
+    Font font;
+    const char* id;
+    const char* path;
+    i32* codepoints;
+    i32 n_codepoints;
+    i32 size;
+} FontAsset;
+
+// Everything a cached atlas was baked from. A cache file is only used if its key matches byte for byte.
+typedef struct {
+    u32 magic;
+    u32 version;
+    i32 size;
+    i32 glyph_padding;
+    i32 n_glyphs;
+    u32 codepoint_hash;
+    i64 source_size;
+    i64 source_mtime;
+} FontCacheKey;
+
+// Font atlas cache file, in host byte order as it never leaves the machine that wrote it:
+//
+//   FontCacheHeader
+//   FontCacheGlyph[key.n_glyphs]
+//   atlas pixels, GetPixelDataSize(atlas_width, atlas_height, atlas_format) bytes
+typedef struct {
+    FontCacheKey key;
+    i32 atlas_width;
+    i32 atlas_height;
+    i32 atlas_format;
+    u32 reserved;
+} FontCacheHeader;
+
+typedef struct {
+    i32 value;
+    i32 offset_x;
+    i32 offset_y;
+    i32 advance_x;
+    Rectangle rec;
+} FontCacheGlyph;
+
+_Static_assert(sizeof(FontCacheKey) == 40, "FontCacheKey is compared with memcmp, so it can't have padding");
+
+typedef struct {
+    const char* id;
+    u32 hash;
+    u32 handle; // ASSET_NONE marks an empty entry
+} AssetIndexEntry;
+
+// Open addressed map from interned ID to handle, doubled whenever it gets half full.
+typedef struct {
+    AssetIndexEntry* entries;
+    u32 cap;
+    u32 count;
+} AssetIndex;
+
+// Textures load in two stages: the worker thread decodes the file into an Image, then assetmgr_update
+// uploads it on the main thread. Until then the texture's record holds the placeholder. Records live in
+// their own virtual arenas, so they never move and pointers into them stay valid as more are added.
+//
+// If there's an asset pack (see asset_pack.h) next to the executable, or failing that in the working
+// directory, it's mapped at init and assets are decoded straight out of it; anything the pack lacks is still
+// read from the loose file. The path it was found at is kept in pack_path.
+//
+// With hot reloading on, files written under the watched directories are reloaded into the records they
+// were loaded into, so Texture2D* and Font* pointers stay valid and simply see the new data. Textures go
+// through the worker like any other async load and keep showing the old version until the new one is up.
 typedef struct AssetManager {
-    size_t n_textures;
-    size_t n_fonts;
-    const char* font_ids[MAX_FONTS];
-    Font fonts[MAX_FONTS];
-    const char* texture_ids[MAX_TEXTURES];
-    Texture2D textures[MAX_TEXTURES];
+    MappedFile pack; // Empty when loading loose files
+    char pack_path[ASSET_PACK_PATH_MAX];
+    FileWatch watch;
+    bool watching;
+
+    MemoryArena texture_mem;
+    MemoryArena font_mem;
+    TextureAsset* textures;
+    FontAsset* fonts;
+    u32 n_textures;
+    u32 n_fonts;
+    AssetIndex texture_index;
+    AssetIndex font_index;
+
+    Thread worker;
+    Mutex lock;
+    CondVar wake;
+    CondVar decoded;
+    u32 queue_head;
+    u32 queue_tail;
+    bool quit;
 } AssetManager;
 
 bool assetmgr_init(MemoryArena* game_mem);
-Texture2D* assetmgr_load_texture(const char* fname);
-Texture2D* assetmgr_get_texture(const char* id);
-Font* assetmgr_load_font(const char* fname, const char* id);
-Font* assetmgr_get_font(const char* id);
+bool assetmgr_watch(const char** dirs, const u32 n_dirs);
+void assetmgr_update(void);
+TextureHandle assetmgr_load_texture(const char* fname);
+TextureHandle assetmgr_load_texture_async(const char* fname);
+TextureHandle assetmgr_find_texture(const char* id);
+Texture2D* assetmgr_get_texture(const TextureHandle h);
+u32 assetmgr_get_texture_version(const TextureHandle h);
+bool assetmgr_is_busy(void);
+FontHandle assetmgr_load_font(const char* fname, const char* id, const i32 size, i32* codepoints, const i32 n_codepoints);
+FontHandle assetmgr_find_font(const char* id);
+Font* assetmgr_get_font(const FontHandle h);
 void assetmgr_destroy(void);
 
 #endif // !ASSET_MANAGER_H_
@@ -0,0 +1,89 @@
+#ifndef ASSET_PACK_H_
+#define ASSET_PACK_H_
+
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// Looked for next to the executable, where the build puts it, then in the working directory
+#define ASSET_PACK_PATH "assets.pack"
+#define ASSET_PACK_MAGIC 0x4B504646U // "FFPK" read as a little-endian u32
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_MAX_PATH 120
+#define ASSET_PACK_ALIGN 16
+
+// Asset pack format, built by tools/pack_assets.c and mapped whole by the asset manager. All fields are
+// little-endian.
+//
+//   AssetPackHeader
+//   AssetPackEntry[n_entries]   Sorted by path, so lookups can binary search
+//   file data                   Each file starts on an ASSET_PACK_ALIGN boundary
+//
+// Paths are stored as the game asks for them, e.g. "assets/textures/tilemap.png", so the same IDs work
+// with and without a pack.
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 n_entries;
+    u32 reserved;
+} AssetPackHeader;
+
+typedef struct {
+    char path[ASSET_PACK_MAX_PATH]; // NUL-terminated
+    u32 offset;                     // From the start of the pack
+    u32 size;
+} AssetPackEntry;
+
+_Static_assert(sizeof(AssetPackHeader) == 16, "AssetPackHeader layout is part of the pack format");
+_Static_assert(sizeof(AssetPackEntry) == 128, "AssetPackEntry layout is part of the pack format");
+
+// Checks that the header and entry table fit in the pack and every entry points inside it.
+static inline bool asset_pack_validate(const u8* pack, const size_t size)
+{
+    if (size < sizeof(AssetPackHeader)) {
+        return false;
+    }
+
+    const AssetPackHeader* header = (const AssetPackHeader*)pack;
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION ||
+        header->n_entries > (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry)) {
+        return false;
+    }
+
+    const AssetPackEntry* entries = (const AssetPackEntry*)(pack + sizeof(AssetPackHeader));
+    for (u32 i = 0; i < header->n_entries; ++i) {
+        const AssetPackEntry* e = &entries[i];
+        if (memchr(e->path, '\0', ASSET_PACK_MAX_PATH) == NULL || e->offset > size || e->size > size - e->offset) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the entry for path, or NULL if the pack doesn't have it. The pack must have been validated.
+static inline const AssetPackEntry* asset_pack_find(const u8* pack, const char* path)
+{
+    const AssetPackHeader* header = (const AssetPackHeader*)pack;
+    const AssetPackEntry* entries = (const AssetPackEntry*)(pack + sizeof(AssetPackHeader));
+
+    u32 lo = 0;
+    u32 hi = header->n_entries;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(entries[mid].path, path);
+        if (cmp == 0) {
+            return &entries[mid];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+#endif // !ASSET_PACK_H_
@@ -0,0 +1,308 @@
+#include "chunk_stream.h"
+#include "arena.h"
+#include "raylib.h"
+#include "thread.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <string.h>
+
+static void worker_run(void* arg);
+static void collect_loaded(ChunkStream* cs);
+static void wait_idle(ChunkStream* cs);
+static i16 find_slot(const ChunkStream* cs, const u32 chunk);
+static i16 claim_slot(ChunkStream* cs);
+static void table_insert(ChunkStream* cs, const u32 chunk, const i16 slot);
+static void table_remove(ChunkStream* cs, const u32 chunk);
+static u32 table_home(const ChunkStream* cs, const u32 chunk);
+
+bool chunk_stream_init(ChunkStream* cs, MemoryArena* arena, const u16 n_slots)
+{
+    *cs = (ChunkStream){.n_slots = n_slots};
+
+    u32 table_size = 1;
+    cs->table_shift = 32;
+    while (table_size < (u32)n_slots * 2) {
+        table_size <<= 1;
+        cs->table_shift--;
+    }
+    cs->table_mask = table_size - 1;
+
+    cs->slots = (ResidentChunk*)arena_alloc_tagged(arena, sizeof(ResidentChunk) * n_slots, 16, "Chunks");
+    cs->table = (i16*)arena_alloc_tagged(arena, sizeof(i16) * table_size, 16, "Chunks");
+    cs->queue = (u16*)arena_alloc_tagged(arena, sizeof(u16) * n_slots, 16, "Chunks");
+    if (!cs->slots || !cs->table || !cs->queue) {
+        util_error("Failed to allocate for chunk stream");
+        return false;
+    }
+    memset(cs->slots, 0, sizeof(ResidentChunk) * n_slots);
+    memset(cs->table, 0xff, sizeof(i16) * table_size);
+
+    mutex_init(&cs->lock);
+    cond_init(&cs->wake);
+    cond_init(&cs->idle);
+    if (!thread_start(&cs->worker, worker_run, cs)) {
+        util_error("Failed to start chunk stream worker");
+        cond_destroy(&cs->idle);
+        cond_destroy(&cs->wake);
+        mutex_destroy(&cs->lock);
+        return false;
+    }
+
+    return true;
+}
+
+void chunk_stream_destroy(ChunkStream* cs)
+{
+    mutex_lock(&cs->lock);
+    cs->quit = true;
+    cond_signal(&cs->wake);
+    mutex_unlock(&cs->lock);
+    thread_join(&cs->worker);
+
+    cond_destroy(&cs->idle);
+    cond_destroy(&cs->wake);
+    mutex_destroy(&cs->lock);
+
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        if (cs->slots[i].target.id > 0) {
+            UnloadRenderTexture(cs->slots[i].target);
+        }
+    }
+}
+
+// Starts streaming from source. Unless keep_resident is set (source is a copy of the current one), every
+// resident chunk is dropped without being written back. Slots keep their render textures for reuse.
+void chunk_stream_set_source(ChunkStream* cs, ChunkData* source, const u32 n_chunks, const bool keep_resident)
+{
+    wait_idle(cs);
+    if (keep_resident) {
+        mutex_lock(&cs->lock);
+        cs->source = source;
+        mutex_unlock(&cs->lock);
+        return;
+    }
+
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        ResidentChunk* rc = &cs->slots[i];
+        rc->state = CHUNK_FREE;
+        rc->loaded = false;
+        rc->modified = false;
+    }
+    memset(cs->table, 0xff, sizeof(i16) * (cs->table_mask + 1));
+    cs->n_resident = 0;
+
+    // The worker is idle, so nothing reads source while it changes
+    mutex_lock(&cs->lock);
+    cs->source = source;
+    cs->n_chunks = n_chunks;
+    mutex_unlock(&cs->lock);
+}
+
+// Starts a new streaming frame and picks up any chunks the worker has finished with.
+void chunk_stream_begin_frame(ChunkStream* cs)
+{
+    cs->frame++;
+    collect_loaded(cs);
+}
+
+// Marks the chunk as wanted this frame, queueing it to be paged in if it isn't already. Returns false when
+// every slot holds a chunk that is also wanted this frame.
+bool chunk_stream_request(ChunkStream* cs, const u32 chunk)
+{
+    if (chunk >= cs->n_chunks) {
+        return false;
+    }
+
+    i16 slot = find_slot(cs, chunk);
+    if (slot >= 0) {
+        cs->slots[slot].last_used = cs->frame;
+        return true;
+    }
+
+    slot = claim_slot(cs);
+    if (slot < 0) {
+        return false;
+    }
+
+    ResidentChunk* rc = &cs->slots[slot];
+    rc->chunk = chunk;
+    rc->last_used = cs->frame;
+    rc->state = CHUNK_LOADING;
+    rc->loaded = false;
+    rc->modified = false;
+    table_insert(cs, chunk, slot);
+
+    mutex_lock(&cs->lock);
+    cs->queue[(cs->queue_head + cs->queue_len) % cs->n_slots] = (u16)slot;
+    cs->queue_len++;
+    cs->pending++;
+    cond_signal(&cs->wake);
+    mutex_unlock(&cs->lock);
+
+    return true;
+}
+
+// Blocks until every queued chunk is resident.
+void chunk_stream_wait(ChunkStream* cs)
+{
+    wait_idle(cs);
+    collect_loaded(cs);
+}
+
+// Copies edited chunks back into the source so it reflects everything the resident set knows about.
+void chunk_stream_write_back(ChunkStream* cs)
+{
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        ResidentChunk* rc = &cs->slots[i];
+        if (rc->state == CHUNK_RESIDENT && rc->modified) {
+            cs->source[rc->chunk] = rc->data;
+            rc->modified = false;
+        }
+    }
+}
+
+// Returns the chunk if it's resident, or NULL if it's unloaded or still being paged in.
+ResidentChunk* chunk_stream_get(const ChunkStream* cs, const u32 chunk)
+{
+    i16 slot = find_slot(cs, chunk);
+    if (slot < 0 || cs->slots[slot].state != CHUNK_RESIDENT) {
+        return NULL;
+    }
+
+    return &cs->slots[slot];
+}
+
+// ································································································
+
+static void worker_run(void* arg)
+{
+    ChunkStream* cs = (ChunkStream*)arg;
+
+    mutex_lock(&cs->lock);
+    while (true) {
+        while (!cs->quit && cs->queue_len == 0) {
+            cond_wait(&cs->wake, &cs->lock);
+        }
+        if (cs->quit) {
+            break;
+        }
+
+        ResidentChunk* rc = &cs->slots[cs->queue[cs->queue_head]];
+        cs->queue_head = (u16)((cs->queue_head + 1) % cs->n_slots);
+        cs->queue_len--;
+        const ChunkData* src = &cs->source[rc->chunk];
+        mutex_unlock(&cs->lock);
+
+        // Any page faults on a mapped source land here rather than on the main thread
+        memcpy(&rc->data, src, sizeof(ChunkData));
+
+        mutex_lock(&cs->lock);
+        rc->loaded = true;
+        cs->pending--;
+        if (cs->pending == 0) {
+            cond_broadcast(&cs->idle);
+        }
+    }
+    mutex_unlock(&cs->lock);
+}
+
+static void collect_loaded(ChunkStream* cs)
+{
+    mutex_lock(&cs->lock);
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        ResidentChunk* rc = &cs->slots[i];
+        if (rc->state == CHUNK_LOADING && rc->loaded) {
+            rc->state = CHUNK_RESIDENT;
+            rc->dirty = true;
+            cs->n_resident++;
+        }
+    }
+    mutex_unlock(&cs->lock);
+}
+
+static void wait_idle(ChunkStream* cs)
+{
+    mutex_lock(&cs->lock);
+    while (cs->pending > 0) {
+        cond_wait(&cs->idle, &cs->lock);
+    }
+    mutex_unlock(&cs->lock);
+}
+
+static i16 find_slot(const ChunkStream* cs, const u32 chunk)
+{
+    for (u32 i = table_home(cs, chunk);; i = (i + 1) & cs->table_mask) {
+        i16 slot = cs->table[i];
+        if (slot < 0 || cs->slots[slot].chunk == chunk) {
+            return slot;
+        }
+    }
+}
+
+// Returns a free slot, or evicts the least recently requested resident chunk that wasn't requested this
+// frame. Returns -1 if there's nothing to evict.
+static i16 claim_slot(ChunkStream* cs)
+{
+    i16 victim = -1;
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        ResidentChunk* rc = &cs->slots[i];
+        if (rc->state == CHUNK_FREE) {
+            return (i16)i;
+        }
+        if (rc->state == CHUNK_RESIDENT && rc->last_used != cs->frame &&
+            (victim < 0 || rc->last_used < cs->slots[victim].last_used)) {
+            victim = (i16)i;
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+
+    ResidentChunk* rc = &cs->slots[victim];
+    if (rc->modified) {
+        cs->source[rc->chunk] = rc->data;
+    }
+    table_remove(cs, rc->chunk);
+    rc->state = CHUNK_FREE;
+    cs->n_resident--;
+
+    return victim;
+}
+
+static void table_insert(ChunkStream* cs, const u32 chunk, const i16 slot)
+{
+    u32 i = table_home(cs, chunk);
+    while (cs->table[i] >= 0) {
+        i = (i + 1) & cs->table_mask;
+    }
+    cs->table[i] = slot;
+}
+
+// Backward shift deletion, so lookups never need tombstones.
+static void table_remove(ChunkStream* cs, const u32 chunk)
+{
+    u32 i = table_home(cs, chunk);
+    while (cs->slots[cs->table[i]].chunk != chunk) {
+        i = (i + 1) & cs->table_mask;
+    }
+    cs->table[i] = -1;
+
+    for (u32 j = (i + 1) & cs->table_mask; cs->table[j] >= 0; j = (j + 1) & cs->table_mask) {
+        // Entries whose home lies cyclically in (i, j] are still reachable and stay put
+        u32 home = table_home(cs, cs->slots[cs->table[j]].chunk);
+        bool reachable = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (reachable) {
+            continue;
+        }
+
+        cs->table[i] = cs->table[j];
+        cs->table[j] = -1;
+        i = j;
+    }
+}
+
+// Fibonacci hashing; neighbouring chunks land in different buckets.
+static u32 table_home(const ChunkStream* cs, const u32 chunk)
+{
+    return (u32)(((u64)(chunk * 2654435761U)) >> cs->table_shift);
+}
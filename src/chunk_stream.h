@@ -0,0 +1,81 @@
+#ifndef CHUNK_STREAM_H_
+#define CHUNK_STREAM_H_
+
+#include "arena.h"
+#include "raylib.h"
+#include "thread.h"
+#include "utils.h"
+#include <stdbool.h>
+
+#define CHUNK_TILES 16
+
+// Upper bound on chunks held in memory at once, each with its tile data and baked texture.
+#ifndef CHUNK_STREAM_SLOTS
+#define CHUNK_STREAM_SLOTS 96
+#endif
+
+// Index into the tileset's lookup table, offset by one so that 0 marks an empty cell.
+typedef u16 TileId;
+
+// One CHUNK_TILES x CHUNK_TILES block of the world, laid out exactly as it's stored in a level file.
+typedef struct {
+    TileId tiles[CHUNK_TILES * CHUNK_TILES];
+    u16 solid[CHUNK_TILES]; // One bit per cell per row, set when the cell's tile is solid
+} ChunkData;
+
+_Static_assert(CHUNK_TILES <= 16, "Chunk solid rows are stored as u16");
+
+typedef enum {
+    CHUNK_FREE = 0,
+    CHUNK_LOADING,
+    CHUNK_RESIDENT,
+} ChunkState;
+
+// A slot in the resident set. The worker fills data while the slot is loading; after that it belongs to the
+// main thread, which bakes it into target and edits it in place.
+typedef struct {
+    ChunkData data;
+    RenderTexture2D target;
+    u32 chunk;     // Index into the source, chunk_row * chunks_wide + chunk_col
+    u32 last_used; // Frame the chunk was last requested
+    u8 state;
+    bool loaded;   // Set by the worker, guarded by ChunkStream.lock
+    bool dirty;    // Needs re-baking
+    bool empty;
+    bool modified; // Edited since it was paged in, written back to the source on eviction
+} ResidentChunk;
+
+// Pages chunks in from a source array (usually a mapped level file) on a worker thread and evicts the least
+// recently requested ones once all slots are taken. Everything but the copy itself runs on the main thread.
+typedef struct {
+    ResidentChunk* slots;
+    u16 n_slots;
+    u16 n_resident;
+    i16* table; // Open addressed chunk -> slot lookup, -1 when empty
+    u32 table_mask;
+    u8 table_shift;
+    ChunkData* source;
+    u32 n_chunks;
+    u32 frame;
+
+    Thread worker;
+    Mutex lock;
+    CondVar wake;
+    CondVar idle;
+    u16* queue; // Ring of slots waiting to be loaded
+    u16 queue_head;
+    u16 queue_len;
+    u16 pending; // Queued or being copied
+    bool quit;
+} ChunkStream;
+
+bool chunk_stream_init(ChunkStream* cs, MemoryArena* arena, const u16 n_slots);
+void chunk_stream_destroy(ChunkStream* cs);
+void chunk_stream_set_source(ChunkStream* cs, ChunkData* source, const u32 n_chunks, const bool keep_resident);
+void chunk_stream_begin_frame(ChunkStream* cs);
+bool chunk_stream_request(ChunkStream* cs, const u32 chunk);
+void chunk_stream_wait(ChunkStream* cs);
+void chunk_stream_write_back(ChunkStream* cs);
+ResidentChunk* chunk_stream_get(const ChunkStream* cs, const u32 chunk);
+
+#endif // !CHUNK_STREAM_H_
@@ -0,0 +1,196 @@
+#include "draw_list.h"
+#include "arena.h"
+#include "raylib.h"
+#include "state.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define DRAW_KEY_INDEX_MASK 0xFFFFFFFFull
+#define DRAW_KEY_TEXTURE_MASK 0xFFFFFFull
+
+static GameState* state;
+static DrawList* list;
+
+static void push(const DrawLayer layer,
+                 const Texture2D tex,
+                 const Rectangle src,
+                 const Rectangle dst,
+                 const Vector2 origin,
+                 const f32 rotation,
+                 const Color tint);
+static void push_shape(
+    const DrawLayer layer, const Rectangle dst, const Vector2 origin, const f32 rotation, const Color color);
+static int compare_keys(const void* a, const void* b);
+
+bool draw_list_init(MemoryArena* mem, GameState* game_state)
+{
+    state = game_state;
+
+    list = (DrawList*)arena_alloc_tagged(mem, sizeof(DrawList), 16, "DrawList");
+    DrawCmd* cmds = (DrawCmd*)arena_alloc_tagged(mem, sizeof(DrawCmd) * DRAW_LIST_CAPACITY, 16, "DrawList");
+    u64* keys = (u64*)arena_alloc_tagged(mem, sizeof(u64) * DRAW_LIST_CAPACITY, 16, "DrawList");
+    if (!list || !cmds || !keys) {
+        util_error("Failed to allocate draw list");
+        return false;
+    }
+    *list = (DrawList){
+        .cmds = cmds,
+        .keys = keys,
+    };
+
+    return true;
+}
+
+void draw_sprite(
+    const DrawLayer layer, const Texture2D* tex, const Rectangle src, const Rectangle dst, const Color tint)
+{
+    push(layer, *tex, src, dst, (Vector2){0, 0}, 0.0f, tint);
+}
+
+void draw_rect(const DrawLayer layer, const Rectangle rec, const Color color)
+{
+    push_shape(layer, rec, (Vector2){0, 0}, 0.0f, color);
+}
+
+// Same edges as DrawRectangleLinesEx: top and bottom span the width, the sides fit between them
+void draw_rect_lines(const DrawLayer layer, const Rectangle rec, const f32 thick, const Color color)
+{
+    f32 t = thick;
+    if (t > rec.width || t > rec.height) {
+        t = fminf(rec.width, rec.height) * 0.5f;
+    }
+
+    draw_rect(layer, (Rectangle){rec.x, rec.y, rec.width, t}, color);
+    draw_rect(layer, (Rectangle){rec.x, rec.y + rec.height - t, rec.width, t}, color);
+    draw_rect(layer, (Rectangle){rec.x, rec.y + t, t, rec.height - t * 2.0f}, color);
+    draw_rect(layer, (Rectangle){rec.x + rec.width - t, rec.y + t, t, rec.height - t * 2.0f}, color);
+}
+
+// A quad thick wide centred on the line, like DrawLineEx
+void draw_line(const DrawLayer layer, const Vector2 start, const Vector2 end, const f32 thick, const Color color)
+{
+    f32 dx = end.x - start.x;
+    f32 dy = end.y - start.y;
+    f32 length = sqrtf(dx * dx + dy * dy);
+    if (length <= 0.0f || thick <= 0.0f) {
+        return;
+    }
+
+    Rectangle dst = {start.x, start.y, length, thick};
+    push_shape(layer, dst, (Vector2){0.0f, thick * 0.5f}, atan2f(dy, dx) * RAD2DEG, color);
+}
+
+// Lays text out the way DrawTextEx does, queuing a sprite per glyph from the font's atlas. NULL text, e.g.
+// from an arena_printf that ran out of room, draws nothing, as it does with DrawTextEx.
+void draw_text(const DrawLayer layer,
+               const Font* font,
+               const char* text,
+               const Vector2 pos,
+               const f32 size,
+               const f32 spacing,
+               const Color tint)
+{
+    if (!text) {
+        return;
+    }
+
+    f32 scale = size / (f32)font->baseSize;
+    f32 pad = (f32)font->glyphPadding;
+    f32 x = 0.0f;
+    f32 y = 0.0f;
+
+    for (const char* p = text; *p;) {
+        i32 n_bytes = 0;
+        i32 codepoint = GetCodepointNext(p, &n_bytes);
+        p += n_bytes;
+
+        if (codepoint == '\n') {
+            x = 0.0f;
+            y += size + DRAW_TEXT_LINE_SPACING;
+            continue;
+        }
+
+        i32 i = GetGlyphIndex(*font, codepoint);
+        Rectangle rec = font->recs[i];
+        const GlyphInfo* glyph = &font->glyphs[i];
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            Rectangle src = {rec.x - pad, rec.y - pad, rec.width + pad * 2.0f, rec.height + pad * 2.0f};
+            Rectangle dst = {
+                .x = pos.x + x + ((f32)glyph->offsetX - pad) * scale,
+                .y = pos.y + y + ((f32)glyph->offsetY - pad) * scale,
+                .width = src.width * scale,
+                .height = src.height * scale,
+            };
+            push(layer, font->texture, src, dst, (Vector2){0, 0}, 0.0f, tint);
+        }
+
+        x += (glyph->advanceX == 0 ? rec.width : (f32)glyph->advanceX) * scale + spacing;
+    }
+}
+
+// Submits everything queued since the last flush, by layer and then by texture, and empties the list.
+// Counts a draw call per run of one texture, which is as often as rlgl has to end a batch because of us.
+void draw_list_flush(void)
+{
+    if (list->n_cmds == 0) {
+        return;
+    }
+
+    qsort(list->keys, list->n_cmds, sizeof(list->keys[0]), compare_keys);
+
+    u32 bound = 0;
+    for (u32 i = 0; i < list->n_cmds; ++i) {
+        const DrawCmd* cmd = &list->cmds[list->keys[i] & DRAW_KEY_INDEX_MASK];
+        if (i == 0 || cmd->tex.id != bound) {
+            state->stats.draw_calls++;
+            state->stats.texture_switches += i > 0 ? 1 : 0;
+            bound = cmd->tex.id;
+        }
+        DrawTexturePro(cmd->tex, cmd->src, cmd->dst, cmd->origin, cmd->rotation, cmd->tint);
+    }
+
+    state->stats.draw_cmds += list->n_cmds;
+    list->n_cmds = 0;
+}
+
+// ································································································
+
+static void push(const DrawLayer layer,
+                 const Texture2D tex,
+                 const Rectangle src,
+                 const Rectangle dst,
+                 const Vector2 origin,
+                 const f32 rotation,
+                 const Color tint)
+{
+    if (list->n_cmds == DRAW_LIST_CAPACITY) {
+        draw_list_flush();
+    }
+
+    u32 i = list->n_cmds++;
+    list->cmds[i] = (DrawCmd){
+        .tex = tex,
+        .src = src,
+        .dst = dst,
+        .origin = origin,
+        .rotation = rotation,
+        .tint = tint,
+    };
+    list->keys[i] = (u64)layer << 56 | (u64)(tex.id & DRAW_KEY_TEXTURE_MASK) << 32 | i;
+}
+
+// Shapes are quads of the white texel raylib's own shape functions draw with, so they batch with each other
+static void push_shape(
+    const DrawLayer layer, const Rectangle dst, const Vector2 origin, const f32 rotation, const Color color)
+{
+    push(layer, GetShapesTexture(), GetShapesTextureRectangle(), dst, origin, rotation, color);
+}
+
+static int compare_keys(const void* a, const void* b)
+{
+    u64 ka = *(const u64*)a;
+    u64 kb = *(const u64*)b;
+    return (ka > kb) - (ka < kb);
+}
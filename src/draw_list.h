@@ -0,0 +1,68 @@
+#ifndef DRAW_LIST_H_
+#define DRAW_LIST_H_
+
+#include "raylib.h"
+#include "state.h"
+#include "utils.h"
+#include <stdbool.h>
+
+// Commands that can be queued between flushes. A full list is flushed early, which only keeps the layering
+// of what was queued before and after apart.
+#define DRAW_LIST_CAPACITY 16384
+
+// Line spacing raylib's DrawTextEx uses unless SetTextLineSpacing changes it
+#define DRAW_TEXT_LINE_SPACING 2.0f
+
+// Draw order between flushes. Within a layer, draws are grouped by texture and only keep their order among
+// draws of the same texture, so anything that has to cover a different texture needs a later layer.
+typedef enum {
+    // World space, queued under the camera
+    DRAW_LAYER_GRID,
+    DRAW_LAYER_MAP,
+    DRAW_LAYER_ENTITIES,
+    DRAW_LAYER_BRUSH,
+    DRAW_LAYER_WORLD_LINES,
+
+    // Screen space
+    DRAW_LAYER_UI_BACKGROUND,
+    DRAW_LAYER_UI,
+    DRAW_LAYER_UI_LINES,
+    DRAW_LAYER_UI_TEXT,
+} DrawLayer;
+
+// Every draw is lowered to a textured quad when it's queued. Shapes use raylib's shapes texture, text is
+// broken up into glyphs from the font's atlas.
+typedef struct {
+    Texture2D tex;
+    Rectangle src;
+    Rectangle dst;
+    Vector2 origin;
+    f32 rotation;
+    Color tint;
+} DrawCmd;
+
+// Records what would otherwise be immediate mode raylib draws, so they can be submitted sorted by texture.
+// rlgl starts a new batch on every texture change, which interleaved tileset, icon, font and shape draws
+// otherwise cause all the time.
+typedef struct {
+    DrawCmd* cmds;
+    u64* keys; // Layer, texture id, then index into cmds, which is also the order the draws were queued in
+    u32 n_cmds;
+} DrawList;
+
+bool draw_list_init(MemoryArena* mem, GameState* state);
+void draw_sprite(
+    const DrawLayer layer, const Texture2D* tex, const Rectangle src, const Rectangle dst, const Color tint);
+void draw_rect(const DrawLayer layer, const Rectangle rec, const Color color);
+void draw_rect_lines(const DrawLayer layer, const Rectangle rec, const f32 thick, const Color color);
+void draw_line(const DrawLayer layer, const Vector2 start, const Vector2 end, const f32 thick, const Color color);
+void draw_text(const DrawLayer layer,
+               const Font* font,
+               const char* text,
+               const Vector2 pos,
+               const f32 size,
+               const f32 spacing,
+               const Color tint);
+void draw_list_flush(void);
+
+#endif // !DRAW_LIST_H_
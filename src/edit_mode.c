@@ -1,5 +1,6 @@
 #include "edit_mode.h"
 #include "asset_manager.h"
+#include "draw_list.h"
 #include "gfx.h"
 #include "input.h"
 #include "level.h"
@@ -8,7 +9,25 @@
 #include "ui.h"
 #include <stdbool.h>
 
+typedef enum {
+    ICON_RESET_PLAYER,
+    ICON_TRASH,
+    ICON_LOAD,
+    ICON_SAVE,
+    ICON_QUIT,
+    ICON_COUNT,
+} Icon;
+
+static const char* icon_paths[ICON_COUNT] = {
+    [ICON_RESET_PLAYER] = "assets/textures/recycle-solid-full.png",
+    [ICON_TRASH] = "assets/textures/trash-solid-full.png",
+    [ICON_LOAD] = "assets/textures/folder-open-solid-full.png",
+    [ICON_SAVE] = "assets/textures/floppy-disk-solid-full.png",
+    [ICON_QUIT] = "assets/textures/door-open-solid-full.png",
+};
+
 static GameState* state;
+static TextureHandle icons[ICON_COUNT];
 
 static void update_edit_mode(void);
 static void render_edit_mode_grid(void);
@@ -23,6 +42,11 @@ static void render_edit_mode_brush(void);
 void edit_mode_init(GameState* game_state)
 {
     state = game_state;
+
+    // Start decoding the toolbar icons now, so they're ready by the time the editor is first opened
+    for (u32 i = 0; i < ICON_COUNT; ++i) {
+        icons[i] = assetmgr_load_texture_async(icon_paths[i]);
+    }
 }
 
 void edit_mode_update(void)
@@ -48,6 +72,8 @@ void edit_mode_update(void)
 
 void edit_mode_render(void)
 {
+    level_prerender();
+
     BeginDrawing();
     {
         // GLFW shinnanigans
@@ -63,6 +89,7 @@ void edit_mode_render(void)
             if (!state->ui_hovered) {
                 render_edit_mode_brush();
             }
+            draw_list_flush();
         }
         EndMode2D();
 
@@ -73,6 +100,7 @@ void edit_mode_render(void)
             if (state->debug) {
                 ui_render_debug_ui(state);
             }
+            draw_list_flush();
         }
     }
     EndDrawing();
@@ -91,7 +119,7 @@ static void update_edit_mode(void)
                                     (u8)state->active_level->tilemap.tile_size);
 
     if (input_is_key_pressed(&state->input.kb, KB_F2)) {
-        player_reset(&state->active_level->player);
+        player_reset(state->active_level->player);
     }
 
     if (input_is_key_pressed(&state->input.kb, KB_F4)) {
@@ -126,19 +154,8 @@ static void update_edit_mode(void)
             for (size_t j = 0; j < brush_col_tiles; ++j) {
                 u32 curx = start_gridx + (u32)j;
                 u32 cury = start_gridy + (u32)i;
-                size_t idx = (size_t)((curx * tm->tile_size) + cury);
-
-                tm->tiles[idx] = (Tile){
-                    .src = tm->brush.src,
-                    .dst =
-                        {
-                            .x = (f32)(curx * tm->tile_size),
-                            .y = (f32)(cury * tm->tile_size),
-                            .width = tm->tile_size,
-                            .height = tm->tile_size,
-                        },
-                    .solid = true,
-                };
+
+                tilemap_set_tile(tm, curx, cury, tm->brush.tile_id);
             }
         }
     }
@@ -146,28 +163,30 @@ static void update_edit_mode(void)
     // --- Delete tile ----------------------------------------------------------------------------
     if (input_is_mouse_down(&state->input.mouse, MB_RIGHT)) {
         Vector2 grid = screenp_to_gridp(state->input.mouse.pos_px, (u8)tm->tile_size);
-        size_t idx = (size_t)((grid.x * tm->tile_size) + grid.y);
-        tm->tiles[idx].src = (Rectangle){0};
+        if (grid.x >= 0 && grid.y >= 0) {
+            tilemap_set_tile(tm, (u32)grid.x, (u32)grid.y, TILE_EMPTY);
+        }
     }
 }
 
 static void render_edit_mode_grid(void)
 {
     Tilemap* tm = &state->active_level->tilemap;
-
-    for (size_t i = 0; i < MAX_NUM_TILES; ++i) {
-        u32 x = i % MAP_COL_TILES;
-        u32 y = (u32)(i / MAP_COL_TILES);
-
-        DrawRectangleLinesEx(
-            (Rectangle){
-                .x = (f32)(x * tm->tile_size),
-                .y = (f32)(y * tm->tile_size),
-                .width = tm->tile_size,
-                .height = tm->tile_size,
-            },
-            1.0f / state->camera.zoom,
-            PALEBLUE_DES);
+    Rectangle view = camera_get_view_rect(&state->camera, (f32)GetScreenWidth(), (f32)GetScreenHeight());
+    TileSpan span = tilemap_get_overlapping_tiles(tm, view);
+
+    for (u16 row = span.row_start; row < span.row_end; ++row) {
+        for (u16 col = span.col_start; col < span.col_end; ++col) {
+            draw_rect_lines(DRAW_LAYER_GRID,
+                            (Rectangle){
+                                .x = (f32)(col * tm->tile_size),
+                                .y = (f32)(row * tm->tile_size),
+                                .width = tm->tile_size,
+                                .height = tm->tile_size,
+                            },
+                            1.0f / state->camera.zoom,
+                            PALEBLUE_DES);
+        }
     }
 }
 
@@ -186,13 +205,14 @@ static void render_edit_mode_ui(void)
     };
 
     if (tm->brush.is_set) {
-        DrawTexturePro(*tm->tileset.texture, tm->brush.src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+        draw_sprite(DRAW_LAYER_UI, tm->tileset.texture, tm->brush.src, dst, WHITE);
     } else {
-        DrawRectangleLinesEx(dst, DEBUG_UI_LINE_THICKNESS, PALEBLUE_D);
+        draw_rect_lines(DRAW_LAYER_UI_LINES, dst, DEBUG_UI_LINE_THICKNESS, PALEBLUE_D);
     }
 
-    Font* font = assetmgr_get_font("main");
-    DrawTextEx(*font, "Brush: ", (Vector2){dst.x - 80.0f, dst.y + 8}, UI_EDIT_MODE_SIZE, 1.0f, PALEBLUE_D);
+    Font* font = assetmgr_get_font(state->ui_font);
+    draw_text(
+        DRAW_LAYER_UI_TEXT, font, "Brush: ", (Vector2){dst.x - 80.0f, dst.y + 8}, UI_EDIT_MODE_SIZE, 1.0f, PALEBLUE_D);
 
     if (state->state == GAME_STATE_EDITING) {
         // DrawTextEx(*font, "Reset Player: F2", (Vector2){10.0f, 30}, UI_TEXT_SIZE, 1.0f, PALEBLUE_D);
@@ -202,15 +222,15 @@ static void render_edit_mode_ui(void)
     // --- Reset player ---------------------------------------------------------------------------
     if (ui_draw_image_button((Vector2){(f32)GetScreenWidth() - ((32.0f - UI_PADDING) * 10.0f), UI_PADDING},
                              32.0f,
-                             "assets/textures/recycle-solid-full.png",
+                             icons[ICON_RESET_PLAYER],
                              "Reset Player")) {
-        player_reset(&state->active_level->player);
+        player_reset(state->active_level->player);
     }
 
     // --- Trash level ----------------------------------------------------------------------------
     if (ui_draw_image_button((Vector2){(f32)GetScreenWidth() - ((32.0f - UI_PADDING) * 8.0f), UI_PADDING},
                              32.0f,
-                             "assets/textures/trash-solid-full.png",
+                             icons[ICON_TRASH],
                              "Trash level")) {
         util_debug("trash pressed");
     }
@@ -218,7 +238,7 @@ static void render_edit_mode_ui(void)
     // --- Load level -----------------------------------------------------------------------------
     if (ui_draw_image_button((Vector2){(f32)GetScreenWidth() - ((32.0f - UI_PADDING) * 6.0f), UI_PADDING},
                              32.0f,
-                             "assets/textures/folder-open-solid-full.png",
+                             icons[ICON_LOAD],
                              "Load level")) {
         if (!level_load()) {
             ui_message_box("Error", TextFormat("Failed to load level: %s", ""));
@@ -231,7 +251,7 @@ static void render_edit_mode_ui(void)
     // --- Save level -----------------------------------------------------------------------------
     if (ui_draw_image_button((Vector2){(f32)GetScreenWidth() - ((32.0f - UI_PADDING) * 4.0f), UI_PADDING},
                              32.0f,
-                             "assets/textures/floppy-disk-solid-full.png",
+                             icons[ICON_SAVE],
                              "Save level")) {
         if (!level_save()) {
             ui_message_box("Error", TextFormat("Failed to save level: %s", ""));
@@ -244,7 +264,7 @@ static void render_edit_mode_ui(void)
     // --- Exit -----------------------------------------------------------------------------------
     if (ui_draw_image_button((Vector2){(f32)GetScreenWidth() - 32.0f - UI_PADDING, UI_PADDING},
                              32.0f,
-                             "assets/textures/door-open-solid-full.png",
+                             icons[ICON_QUIT],
                              "Quit")) {
         // TODO: check if there are unsaved changes
         state->is_running = false;
@@ -303,6 +323,8 @@ static bool update_edit_mode_tileset(void)
             tm->brush.size.x = tm->tile_size;
             tm->brush.size.y = tm->tile_size;
         }
+
+        tm->brush.tile_id = tileset_get_tile_id(&tm->tileset, tm->brush.src);
     }
 
     return true;
@@ -326,19 +348,19 @@ static void render_edit_mode_tileset(void)
     };
 
     // --- Render tilset --------------------------------------------------------------------------
-    DrawTexturePro(*ts->texture, src, dst, (Vector2){0}, 0.0f, WHITE);
+    draw_sprite(DRAW_LAYER_UI, ts->texture, src, dst, WHITE);
 
     // --- Render hovered tilset tile indicator ---------------------------------------------------
     if (ts->active) {
-        DrawRectangleLinesEx(
-            (Rectangle){
-                .x = (ts->hovered_tile.x * ts->tile_size * SCALE) + (ts->pos.x * SCALE),
-                .y = (ts->hovered_tile.y * ts->tile_size * SCALE) + (ts->pos.y * SCALE),
-                .width = ts->tile_size * SCALE,
-                .height = ts->tile_size * SCALE,
-            },
-            DEBUG_UI_LINE_THICKNESS,
-            RED);
+        draw_rect_lines(DRAW_LAYER_UI_LINES,
+                        (Rectangle){
+                            .x = (ts->hovered_tile.x * ts->tile_size * SCALE) + (ts->pos.x * SCALE),
+                            .y = (ts->hovered_tile.y * ts->tile_size * SCALE) + (ts->pos.y * SCALE),
+                            .width = ts->tile_size * SCALE,
+                            .height = ts->tile_size * SCALE,
+                        },
+                        DEBUG_UI_LINE_THICKNESS,
+                        RED);
     }
 }
 
@@ -368,9 +390,9 @@ static void render_edit_mode_brush(void)
             dst.width = tm->tile_size;
             dst.height = tm->tile_size;
 
-            DrawTexturePro(*tm->tileset.texture, tm->brush.src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+            draw_sprite(DRAW_LAYER_BRUSH, tm->tileset.texture, tm->brush.src, dst, WHITE);
         }
     }
 
-    DrawRectangleLinesEx(dst, DEBUG_UI_LINE_THICKNESS / state->camera.zoom, GREEN);
+    draw_rect_lines(DRAW_LAYER_WORLD_LINES, dst, DEBUG_UI_LINE_THICKNESS / state->camera.zoom, GREEN);
 }
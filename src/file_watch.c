@@ -0,0 +1,215 @@
+// Kept out of file_watch.h so the platform headers don't leak into files that include raylib.
+#define _DEFAULT_SOURCE
+
+#include "file_watch.h"
+#include "thread.h"
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+static bool add_dir(FileWatch* fw, const char* dir);
+static void watch_run(void* arg);
+static void mark_changed(FileWatch* fw, const char* dir, const char* name);
+
+// Watches each of dirs and everything below it. Paths are reported as dir/name, so relative dirs give
+// relative paths.
+bool file_watch_start(FileWatch* fw, const char** dirs, const u32 n_dirs)
+{
+    *fw = (FileWatch){0};
+
+    fw->fd = inotify_init1(IN_CLOEXEC);
+    if (fw->fd < 0) {
+        util_error("Failed to init inotify");
+        return false;
+    }
+    if (pipe(fw->stop_pipe) != 0) {
+        util_error("Failed to create file watch pipe");
+        close(fw->fd);
+        return false;
+    }
+
+    for (u32 i = 0; i < n_dirs; ++i) {
+        if (!add_dir(fw, dirs[i])) {
+            util_warn("Not watching %s", dirs[i]);
+        }
+    }
+
+    mutex_init(&fw->lock);
+    if (!thread_start(&fw->thread, watch_run, fw)) {
+        util_error("Failed to start file watch thread");
+        mutex_destroy(&fw->lock);
+        close(fw->stop_pipe[0]);
+        close(fw->stop_pipe[1]);
+        close(fw->fd);
+        return false;
+    }
+
+    return true;
+}
+
+void file_watch_stop(FileWatch* fw)
+{
+    char c = 0;
+    if (write(fw->stop_pipe[1], &c, 1) == 1) {
+        thread_join(&fw->thread);
+    }
+
+    mutex_destroy(&fw->lock);
+    close(fw->stop_pipe[0]);
+    close(fw->stop_pipe[1]);
+    close(fw->fd);
+}
+
+#else
+
+bool file_watch_start(FileWatch* fw, const char** dirs, const u32 n_dirs)
+{
+    (void)dirs;
+    (void)n_dirs;
+    *fw = (FileWatch){0};
+    util_warn("File watching isn't supported on this platform");
+    return false;
+}
+
+void file_watch_stop(FileWatch* fw)
+{
+    (void)fw;
+}
+
+#endif
+
+// Copies out up to max_paths changed paths and forgets them. Returns how many were copied.
+u32 file_watch_poll(FileWatch* fw, char (*paths)[FILE_WATCH_MAX_PATH], const u32 max_paths)
+{
+    mutex_lock(&fw->lock);
+    u32 n = fw->n_changed < max_paths ? fw->n_changed : max_paths;
+    memcpy(paths, fw->changed, sizeof(fw->changed[0]) * n);
+    memmove(fw->changed, fw->changed + n, sizeof(fw->changed[0]) * (fw->n_changed - n));
+    fw->n_changed -= n;
+    mutex_unlock(&fw->lock);
+
+    return n;
+}
+
+// ································································································
+
+#ifdef __linux__
+
+static bool add_dir(FileWatch* fw, const char* dir)
+{
+    if (fw->n_dirs == FILE_WATCH_MAX_DIRS || strlen(dir) >= FILE_WATCH_MAX_PATH) {
+        return false;
+    }
+
+    // Editors commonly save by writing a temporary file and renaming it over the original
+    int wd = inotify_add_watch(fw->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        return false;
+    }
+    fw->wds[fw->n_dirs] = wd;
+    strcpy(fw->dirs[fw->n_dirs], dir);
+    fw->n_dirs++;
+
+    DIR* d = opendir(dir);
+    if (!d) {
+        return true;
+    }
+
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        char path[FILE_WATCH_MAX_PATH];
+        int len = snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+        struct stat st;
+        if (len > 0 && (size_t)len < sizeof(path) && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            if (!add_dir(fw, path)) {
+                util_warn("Not watching %s", path);
+            }
+        }
+    }
+    closedir(d);
+
+    return true;
+}
+
+static void watch_run(void* arg)
+{
+    FileWatch* fw = (FileWatch*)arg;
+
+    // Aligned for the inotify_event structs read into it
+    _Alignas(struct inotify_event) char buf[4096];
+
+    struct pollfd fds[2] = {
+        {.fd = fw->fd, .events = POLLIN},
+        {.fd = fw->stop_pipe[0], .events = POLLIN},
+    };
+
+    while (true) {
+        int n = poll(fds, 2, -1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 || (fds[1].revents & POLLIN)) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        ssize_t len = read(fw->fd, buf, sizeof(buf));
+        if (len <= 0) {
+            continue;
+        }
+
+        for (char* p = buf; p < buf + len;) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0 || (ev->mask & IN_ISDIR)) {
+                continue;
+            }
+
+            for (u32 i = 0; i < fw->n_dirs; ++i) {
+                if (fw->wds[i] == ev->wd) {
+                    mark_changed(fw, fw->dirs[i], ev->name);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void mark_changed(FileWatch* fw, const char* dir, const char* name)
+{
+    char path[FILE_WATCH_MAX_PATH];
+    int len = snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if (len < 0 || (size_t)len >= sizeof(path)) {
+        return;
+    }
+
+    mutex_lock(&fw->lock);
+    bool seen = false;
+    for (u32 i = 0; i < fw->n_changed && !seen; ++i) {
+        seen = strcmp(fw->changed[i], path) == 0;
+    }
+    if (!seen && fw->n_changed < FILE_WATCH_MAX_CHANGES) {
+        strcpy(fw->changed[fw->n_changed++], path);
+    } else if (!seen) {
+        util_warn("Too many changed files, missed %s", path);
+    }
+    mutex_unlock(&fw->lock);
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef FILE_WATCH_H_
+#define FILE_WATCH_H_
+
+#include "thread.h"
+#include "utils.h"
+#include <stdbool.h>
+
+#define FILE_WATCH_MAX_PATH 256
+#define FILE_WATCH_MAX_DIRS 32
+#define FILE_WATCH_MAX_CHANGES 64
+
+// Watches directory trees for files being written, on a thread of its own. Changed paths collect until
+// they're drained with file_watch_poll; a file changed several times in between is only reported once.
+// Only implemented with inotify, file_watch_start fails everywhere else.
+typedef struct {
+    Thread thread;
+    Mutex lock;
+    int fd;
+    int stop_pipe[2]; // Written to by file_watch_stop, wakes the thread out of poll()
+
+    u32 n_dirs;
+    int wds[FILE_WATCH_MAX_DIRS];
+    char dirs[FILE_WATCH_MAX_DIRS][FILE_WATCH_MAX_PATH];
+
+    // Guarded by lock
+    u32 n_changed;
+    char changed[FILE_WATCH_MAX_CHANGES][FILE_WATCH_MAX_PATH];
+} FileWatch;
+
+bool file_watch_start(FileWatch* fw, const char** dirs, const u32 n_dirs);
+u32 file_watch_poll(FileWatch* fw, char (*paths)[FILE_WATCH_MAX_PATH], const u32 max_paths);
+void file_watch_stop(FileWatch* fw);
+
+#endif // !FILE_WATCH_H_
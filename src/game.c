@@ -1,12 +1,14 @@
 #include "game.h"
 #include "arena.h"
 #include "asset_manager.h"
+#include "draw_list.h"
 #include "edit_mode.h"
 #include "gameover_screen.h"
 #include "gfx.h"
 #include "input.h"
 #include "level.h"
 #include "main_menu_screen.h"
+#include "player.h"
 #include "state.h"
 #include "ui.h"
 #include "utils.h"
@@ -15,14 +17,22 @@
 static MemoryArena* game_mem;
 static MemoryArena level_mem;
 static GameState state;
+static bool low_res;
+static RenderTexture2D world_target; // Only used in low_res mode
+static bool sim_resumed;              // Gameplay just started, so the last frame time wasn't spent playing
 
 static bool start_new(MemoryArena* level_mem);
+static bool should_idle(void);
 static void update(void);
 static void render(void);
+static void begin_world(void);
+static void end_world(void);
 
-bool game_init(MemoryArena* mem)
+bool game_init(MemoryArena* mem, const GameOptions* options)
 {
     game_mem = mem;
+    state.game_mem = game_mem;
+    arena_init_virtual(&state.frame_mem, FRAME_MEM_SIZE);
 
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Food Fight!");
     SetTargetFPS(60);
@@ -33,18 +43,23 @@ bool game_init(MemoryArena* mem)
         return false;
     }
 
-    Font* tf = assetmgr_load_font("assets/fonts/FiraCode-Regular.ttf", "main");
-    if (!tf) {
-        util_error("Failed to start level");
+    if (!draw_list_init(game_mem, &state)) {
+        util_error("Failed to init draw list");
         return false;
     }
-    Font* ef = assetmgr_load_font("assets/fonts/FontAwesome.ttf", "emoji");
-    if (!ef) {
-        util_error("Failed to start level");
-        return false;
+
+    low_res = options->low_res;
+    if (options->hot_reload) {
+        const char* dirs[] = GAME_WATCH_DIRS;
+        if (!assetmgr_watch(dirs, sizeof(dirs) / sizeof(dirs[0]))) {
+            util_warn("Hot reloading is unavailable");
+        }
     }
 
-    ui_init(&state);
+    if (!ui_init(&state)) {
+        util_error("Failed to init UI");
+        return false;
+    }
 
     edit_mode_init(&state);
     main_menu_init(&state);
@@ -58,14 +73,35 @@ bool game_init(MemoryArena* mem)
 
 void game_run(void)
 {
-    arena_init(&level_mem, 1 * MB); // TODO: size??
+    arena_init_virtual(&level_mem, 1 * GB);
+    state.level_mem = &level_mem;
 
     if (!start_new(&level_mem)) {
         state.is_running = false;
     }
 
+    State prev_state = state.state;
     while (!WindowShouldClose() && state.is_running) {
+        // Menus and the editor may have idled for a long time, which mustn't turn into simulation steps
+        if (state.state == GAME_STATE_PLAYING && prev_state != GAME_STATE_PLAYING) {
+            sim_resumed = true;
+        }
+        prev_state = state.state;
+
+        if (should_idle()) {
+            // The last frame is still on screen, so there's no need to draw it again
+            WaitTime(IDLE_POLL_SECS);
+            PollInputEvents();
+            continue;
+        }
+
         state.ui_hovered = false;
+        // Rewind without releasing pages, so the frame arena stays warm
+        arena_set_marker(&state.frame_mem, 0);
+        // Keep the finished frame's counters for the overlay before starting this frame's
+        state.prev_stats = state.stats;
+        state.stats = (FrameStats){0};
+        assetmgr_update();
 
         switch (state.state) {
         case GAME_STATE_MAIN_MENU: {
@@ -90,12 +126,28 @@ void game_run(void)
         }
     }
 
+    FILE* f = fopen(ARENA_STATS_FILE, "w");
+    if (f) {
+        arena_dump_stats(game_mem, "game_mem", f);
+        arena_dump_stats(&level_mem, "level_mem", f);
+        arena_dump_stats(&state.frame_mem, "frame_mem", f);
+        fclose(f);
+    } else {
+        util_warn("Failed to write arena stats to %s", ARENA_STATS_FILE);
+    }
+
+    level_destroy();
     arena_free(&level_mem);
+    state.level_mem = NULL;
 }
 
 void game_destroy(void)
 {
+    if (IsRenderTextureValid(world_target)) {
+        UnloadRenderTexture(world_target);
+    }
     assetmgr_destroy();
+    arena_free(&state.frame_mem);
     CloseWindow();
 }
 
@@ -121,6 +173,25 @@ static bool start_new(MemoryArena* level_mem)
     return true;
 }
 
+// Whether to skip this frame. Gameplay always runs; menus and the editor only draw while there's input, a
+// load to finish or a few frames after, so the result of the last input makes it to the screen.
+static bool should_idle(void)
+{
+    static u32 grace_frames = IDLE_GRACE_FRAMES;
+
+    bool busy = state.state == GAME_STATE_PLAYING || input_has_activity(&state.input) || assetmgr_is_busy() ||
+                level_is_streaming();
+    if (busy) {
+        grace_frames = IDLE_GRACE_FRAMES;
+        return false;
+    }
+    if (grace_frames > 0) {
+        grace_frames--;
+        return false;
+    }
+    return true;
+}
+
 static void update(void)
 {
     if (!state.active_level->is_loaded) {
@@ -173,11 +244,40 @@ static void update(void)
     state.camera.target.x = clampf(state.camera.target.x, min_target_x, max_target_x);
     state.camera.target.y = clampf(state.camera.target.y, min_target_y, max_target_y);
 
-    level_update();
+    // Step the simulation at a fixed rate, independent of the render rate. Edge-triggered keys and buttons
+    // are latched until a step consumes them, as a frame may run zero or several steps.
+    static u64 pending_kb_pressed = 0;
+    static u32 pending_pad_pressed = 0;
+    u64 kb_pressed = state.input.kb.pressed | pending_kb_pressed;
+    u32 pad_pressed = state.input.pad.pressed | pending_pad_pressed;
+
+    if (sim_resumed) {
+        // Presses latched when play was left, e.g. alongside Esc, belong to the last session
+        kb_pressed = state.input.kb.pressed;
+        pad_pressed = state.input.pad.pressed;
+        state.sim_accumulator = 0.0f;
+        sim_resumed = false;
+    } else {
+        state.sim_accumulator += fminf(GetFrameTime(), SIM_MAX_FRAME_TIME);
+    }
+    while (state.sim_accumulator >= SIM_DT && state.state == GAME_STATE_PLAYING) {
+        state.input.kb.pressed = kb_pressed;
+        state.input.pad.pressed = pad_pressed;
+        level_update(SIM_DT);
+        kb_pressed = 0;
+        pad_pressed = 0;
+        state.sim_accumulator -= SIM_DT;
+    }
+    pending_kb_pressed = kb_pressed;
+    pending_pad_pressed = pad_pressed;
+
+    state.sim_alpha = state.sim_accumulator / SIM_DT;
 }
 
 static void render(void)
 {
+    level_prerender();
+
     BeginDrawing();
     {
         // GLFW shinnanigans
@@ -185,15 +285,18 @@ static void render(void)
 
         ClearBackground(PALEBLUE);
 
-        BeginMode2D(state.camera);
+        state.camera.target = player_get_render_pos();
+
+        begin_world();
         {
             level_render();
 
             // if (state.state == GAME_STATE_EDITING) {
             //     level_render_edit_mode();
             // }
+            draw_list_flush();
         }
-        EndMode2D();
+        end_world();
 
         // Not affected by camera
         {
@@ -203,7 +306,56 @@ static void render(void)
             if (state.debug) {
                 ui_render_debug_ui(&state);
             }
+            draw_list_flush();
         }
     }
     EndDrawing();
 }
+
+// Starts drawing in world space. In low_res mode the world goes to an offscreen target at 1/SCALE of the
+// window, which is one texel per art pixel at the default zoom, so the GPU fills a quarter of the pixels.
+static void begin_world(void)
+{
+    if (!low_res) {
+        BeginMode2D(state.camera);
+        return;
+    }
+
+    i32 scale = (i32)SCALE;
+    i32 width = (GetScreenWidth() + scale - 1) / scale;
+    i32 height = (GetScreenHeight() + scale - 1) / scale;
+    if (world_target.texture.width != width || world_target.texture.height != height) {
+        if (IsRenderTextureValid(world_target)) {
+            UnloadRenderTexture(world_target);
+        }
+        world_target = LoadRenderTexture(width, height);
+        SetTextureFilter(world_target.texture, TEXTURE_FILTER_POINT);
+    }
+
+    // Same view of the world, with the camera's screen space shrunk to the target
+    Camera2D camera = state.camera;
+    camera.offset.x /= SCALE;
+    camera.offset.y /= SCALE;
+    camera.zoom /= SCALE;
+
+    BeginTextureMode(world_target);
+    ClearBackground(PALEBLUE);
+    BeginMode2D(camera);
+}
+
+// Finishes drawing in world space, upscaling the low_res target over the window with nearest filtering.
+static void end_world(void)
+{
+    EndMode2D();
+    if (!low_res) {
+        return;
+    }
+    EndTextureMode();
+
+    // Render textures are stored upside down
+    f32 width = (f32)world_target.texture.width;
+    f32 height = (f32)world_target.texture.height;
+    Rectangle src = {0.0f, 0.0f, width, -height};
+    Rectangle dst = {0.0f, 0.0f, width * SCALE, height * SCALE};
+    DrawTexturePro(world_target.texture, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+}
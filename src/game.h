@@ -7,7 +7,20 @@
 #define FPS 60
 #define MILLISECS_PER_FRAME 1000 / FPS
 
-bool game_init(MemoryArena* game_mem);
+// Menus and the editor stop redrawing once nothing has happened for IDLE_GRACE_FRAMES, and then only check
+// for input every IDLE_POLL_SECS until something does
+#define IDLE_GRACE_FRAMES 2
+#define IDLE_POLL_SECS 0.05
+
+// Directories watched for asset changes when hot reloading
+#define GAME_WATCH_DIRS {"assets", "data"}
+
+typedef struct {
+    bool hot_reload; // Reload assets as their files change
+    bool low_res;    // Draw the world at 1/SCALE of the window and upscale it, see begin_world
+} GameOptions;
+
+bool game_init(MemoryArena* game_mem, const GameOptions* options);
 void game_run(void);
 void game_destroy(void);
 
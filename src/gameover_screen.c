@@ -20,7 +20,7 @@ static void quit_fn(void);
 void game_over_init(GameState* game_state)
 {
     state = game_state;
-    Font* font = assetmgr_get_font("main");
+    Font* font = assetmgr_get_font(state->ui_font);
 
     u16 text_height = (u16)(GAME_OVER_N_ITEMS * UI_MENU_ITEM_SIZE + UI_HEADER_SIZE);
     u16 starty = (u16)((f32)GetScreenHeight() * 0.5f - text_height * 0.5f + UI_HEADER_SIZE);
@@ -59,7 +59,7 @@ void game_over_update(void)
 
 void game_over_render(void)
 {
-    Font* font = assetmgr_get_font("main");
+    Font* font = assetmgr_get_font(state->ui_font);
 
     BeginDrawing();
     {
@@ -104,6 +104,11 @@ void game_over_render(void)
 
 static void replay_fn(void)
 {
+    if (!level_restart()) {
+        state->state = GAME_STATE_MAIN_MENU;
+        return;
+    }
+
     state->state = GAME_STATE_PLAYING;
 }
 
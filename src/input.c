@@ -2,6 +2,9 @@
 #include "raylib.h"
 #include "utils.h"
 
+static u32 read_keyboard(void);
+static u32 read_mouse_buttons(void);
+static u32 read_gamepad(void);
 static f32 btof(bool b);
 
 void input_process(Input* input)
@@ -9,19 +12,7 @@ void input_process(Input* input)
     // Keyboard -----------------------------------------------------------------------------------
 
     static u32 prev_kb_down = 0;
-    u32 new_kb_down = 0;
-
-    new_kb_down |= IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT) ? KB_A : 0;
-    new_kb_down |= IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN) ? KB_S : 0;
-    new_kb_down |= IsKeyDown(KEY_W) || IsKeyDown(KEY_UP) ? KB_W : 0;
-    new_kb_down |= IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT) ? KB_D : 0;
-    new_kb_down |= IsKeyDown(KEY_SPACE) ? KB_SPACE : 0;
-    new_kb_down |= IsKeyPressed(KEY_F1) ? KB_F1 : 0;
-    new_kb_down |= IsKeyPressed(KEY_F2) ? KB_F2 : 0;
-    new_kb_down |= IsKeyPressed(KEY_F3) ? KB_F3 : 0;
-    new_kb_down |= IsKeyPressed(KEY_F4) ? KB_F4 : 0;
-    new_kb_down |= IsKeyDown(KEY_LEFT_SHIFT) ? KB_LSHFT : 0;
-    new_kb_down |= IsKeyDown(KEY_ESCAPE) ? KB_ESCAPE : 0;
+    u32 new_kb_down = read_keyboard();
 
     // Derive pressed/released from kb btn transition
     input->kb.pressed = (new_kb_down & ~prev_kb_down);  // 0→1 edges
@@ -41,11 +32,7 @@ void input_process(Input* input)
     input->mouse.wheel_delta = GetMouseWheelMove() * 0.5f;
 
     static u32 prev_mouse_down = 0;
-    u32 new_mouse_down = 0;
-
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) new_mouse_down |= MB_LEFT;
-    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON)) new_mouse_down |= MB_RIGHT;
-    if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON)) new_mouse_down |= MB_MIDDLE;
+    u32 new_mouse_down = read_mouse_buttons();
 
     // Derive pressed/released from mouse btn transition
     input->mouse.pressed = (u8)(new_mouse_down & ~prev_mouse_down);
@@ -58,6 +45,18 @@ void input_process(Input* input)
     // Store this state for next frame's prev state
     prev_mouse_down = new_mouse_down;
 
+    // Gamepad ------------------------------------------------------------------------------------
+
+    // Sampled once here like the keyboard, so an edge reaches exactly one simulation step
+    static u32 prev_pad_down = 0;
+    u32 new_pad_down = read_gamepad();
+
+    input->pad.pressed = new_pad_down & ~prev_pad_down;
+    input->pad.released = ~new_pad_down & prev_pad_down;
+    input->pad.down = new_pad_down;
+
+    prev_pad_down = new_pad_down;
+
     // for (size_t i = 0; i < 4; ++i) {
     //     util_debug("%d. %s", i, GetGamepadName(i));
     // }
@@ -93,6 +92,16 @@ bool input_is_mouse_released(Mouse* m, MouseButtons b)
     return (m->released & b) != 0;
 }
 
+bool input_is_pad_down(Gamepad* pad, GamepadButton b)
+{
+    return (pad->down & (1U << b)) != 0;
+}
+
+bool input_is_pad_pressed(Gamepad* pad, GamepadButton b)
+{
+    return (pad->pressed & (1U << b)) != 0;
+}
+
 // I was lazy 😅
 bool input_gamepad_button_pressed(const i32 id, GamepadButton b)
 {
@@ -109,10 +118,28 @@ bool input_gamepad_button_down(const i32 id, GamepadButton b)
     return IsGamepadButtonDown(id, (i32)b);
 }
 
+// True if raylib has seen input that the last input_process hasn't, or a key or button is still held. Reads
+// raylib directly, so it can be asked before this frame's input_process runs.
+bool input_has_activity(const Input* input)
+{
+    if (read_keyboard() != input->kb.down || read_mouse_buttons() != input->mouse.down ||
+        read_gamepad() != input->pad.down) {
+        return true;
+    }
+    if (input->kb.down || input->mouse.down || input->pad.down) {
+        return true;
+    }
+
+    Vector2 mpos = GetMousePosition();
+    bool moved = mpos.x != input->mouse.pos_px.x || mpos.y != input->mouse.pos_px.y;
+    return moved || GetMouseWheelMove() != 0.0f || IsWindowResized();
+}
+
 void input_reset(Input* input)
 {
     input->kb.down = input->kb.pressed = input->kb.released = 0;
     input->mouse.down = input->mouse.pressed = input->mouse.released = 0;
+    input->pad.down = input->pad.pressed = input->pad.released = 0;
     input->kb.axis = (Vector2){0.0f, 0.0f};
 }
 
@@ -122,3 +149,47 @@ static f32 btof(bool b)
 {
     return b ? 1.0 : 0.0;
 }
+
+static u32 read_keyboard(void)
+{
+    u32 kb_down = 0;
+
+    kb_down |= IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT) ? KB_A : 0;
+    kb_down |= IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN) ? KB_S : 0;
+    kb_down |= IsKeyDown(KEY_W) || IsKeyDown(KEY_UP) ? KB_W : 0;
+    kb_down |= IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT) ? KB_D : 0;
+    kb_down |= IsKeyDown(KEY_SPACE) ? KB_SPACE : 0;
+    kb_down |= IsKeyPressed(KEY_F1) ? KB_F1 : 0;
+    kb_down |= IsKeyPressed(KEY_F2) ? KB_F2 : 0;
+    kb_down |= IsKeyPressed(KEY_F3) ? KB_F3 : 0;
+    kb_down |= IsKeyPressed(KEY_F4) ? KB_F4 : 0;
+    kb_down |= IsKeyPressed(KEY_F5) ? KB_F5 : 0;
+    kb_down |= IsKeyDown(KEY_LEFT_SHIFT) ? KB_LSHFT : 0;
+    kb_down |= IsKeyDown(KEY_ESCAPE) ? KB_ESCAPE : 0;
+
+    return kb_down;
+}
+
+static u32 read_mouse_buttons(void)
+{
+    u32 mouse_down = 0;
+
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) mouse_down |= MB_LEFT;
+    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON)) mouse_down |= MB_RIGHT;
+    if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON)) mouse_down |= MB_MIDDLE;
+
+    return mouse_down;
+}
+
+static u32 read_gamepad(void)
+{
+    if (!IsGamepadAvailable(INPUT_GAMEPAD)) {
+        return 0;
+    }
+
+    u32 pad_down = 0;
+    for (i32 b = GAMEPAD_BUTTON_LEFT_FACE_UP; b <= GAMEPAD_BUTTON_RIGHT_THUMB; ++b) {
+        pad_down |= IsGamepadButtonDown(INPUT_GAMEPAD, b) ? 1U << b : 0;
+    }
+    return pad_down;
+}
@@ -5,6 +5,9 @@
 #include <raylib.h>
 #include <stdbool.h>
 
+// The gamepad the player is read from
+#define INPUT_GAMEPAD 3
+
 typedef enum {
     KB_NONE = 0U,
     KB_A = 1U << 0,       // 0x0000_0000_0000_0001
@@ -20,6 +23,7 @@ typedef enum {
     KB_F4 = 1U << 10,     // 0x0000_0100_0000_0000
     KB_LSHFT = 1U << 11,  // 0x0000_1000_0000_0000
     KB_ESCAPE = 1U << 12, // 0x0001_0000_0000_0000
+    KB_F5 = 1U << 13,     // 0x0010_0000_0000_0000
 } KeyboardKeys;
 
 typedef struct {
@@ -44,9 +48,17 @@ typedef struct {
     Vector2 pos_px;
 } Mouse;
 
+// Buttons of INPUT_GAMEPAD, one bit per GamepadButton
+typedef struct {
+    u32 down;
+    u32 pressed;
+    u32 released;
+} Gamepad;
+
 typedef struct {
     Keyboard kb;
     Mouse mouse;
+    Gamepad pad;
 } Input;
 
 void input_process(Input* input);
@@ -56,9 +68,12 @@ bool input_is_key_released(Keyboard* kb, KeyboardKeys k);
 bool input_is_mouse_down(Mouse* m, MouseButtons b);
 bool input_is_mouse_pressed(Mouse* m, MouseButtons b);
 bool input_is_mouse_released(Mouse* m, MouseButtons b);
+bool input_is_pad_down(Gamepad* pad, GamepadButton b);
+bool input_is_pad_pressed(Gamepad* pad, GamepadButton b);
 bool input_gamepad_button_pressed(const i32 id, GamepadButton b);
 bool input_gamepad_button_released(const i32 id, GamepadButton b);
 bool input_gamepad_button_down(const i32 id, GamepadButton b);
+bool input_has_activity(const Input* input);
 void input_reset(Input* input);
 
 #endif // !INPUT_H_
@@ -1,75 +1,205 @@
 #include "level.h"
 #include "arena.h"
 #include "asset_manager.h"
+#include "chunk_stream.h"
+#include "draw_list.h"
 #include "input.h"
+#include "mapped_file.h"
+#include "projectile.h"
 #include "raylib.h"
 #include "state.h"
 #include "utils.h"
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 static Level* active_level;
 static GameState* state;
+static MemoryArena* mem;
 
 static void render_bg(void);
 static void render_map(void);
+static bool init_runtime(void);
+static void stream_view(const bool wait);
+static void set_image(MappedFile* image, ChunkData* chunks, const u16 tiles_wide, const u16 tiles_high);
+static u32 chunk_index(const Tilemap* tm, const u32 col, const u32 row);
+static void chunk_set_tile(const Tilemap* tm, ChunkData* chunk, const u32 col, const u32 row, const TileId id);
+static u8* put_u16(u8* p, const u16 v);
+static u8* put_u32(u8* p, const u32 v);
+static u16 get_u16(const u8* p);
+static u32 get_u32(const u8* p);
+static bool decode_tiles(
+    const Tilemap* tm, const LevelFileHeader* hdr, const u8* payload, const u32 size, ChunkData* out);
+static void decode_chunks(const u8* payload, const size_t n_chunks, ChunkData* out);
+static size_t file_payload_offset(const LevelFileHeader* hdr);
+static u32 count_chunks(const u16 tiles_wide, const u16 tiles_high);
+static bool parse_level_header(const u8* data, const size_t size, const char* path, LevelFileHeader* hdr);
+static bool can_map_in_place(const u8* payload);
+static void bake_chunk(Tilemap* tm, ResidentChunk* rc);
+static void render_map_shader(Tilemap* tm, const TileSpan span);
+static void toggle_renderer(Tilemap* tm);
 
 bool level_init(MemoryArena* level_mem, GameState* game_state)
 {
     state = game_state;
+    mem = level_mem;
 
-    active_level = (Level*)arena_alloc_aligned(level_mem, sizeof(Level), 16);
+    active_level = (Level*)arena_alloc_tagged(level_mem, sizeof(Level), 16, "Level");
     if (!active_level) {
         util_error("Failed to init level mem");
         return false;
     }
+    *active_level = (Level){0};
     state->active_level = active_level;
 
     Tilemap* tm = &active_level->tilemap;
     tm->tile_size = MAP_TILE_SIZE;
-    tm->tiles_wide = MAP_COL_TILES;
-    tm->tiles_high = MAP_ROW_TILES;
 
-    tm->tileset.texture = assetmgr_load_texture("assets/textures/tilemap.png");
-    if (!tm->tileset.texture) {
+    tm->tileset.path = LEVEL_TILESET_PATH;
+    TextureHandle tileset = assetmgr_load_texture(tm->tileset.path);
+    if (tileset == ASSET_NONE) {
         util_error("Failed to load tilemap texture");
         return false;
     }
+    // Records never move, so the pointer can be kept for the life of the level
+    tm->tileset.texture = assetmgr_get_texture(tileset);
+    tm->tileset.handle = tileset;
+    tm->tileset.texture_version = assetmgr_get_texture_version(tileset);
     tm->tileset.tile_size = MAP_TILE_SIZE;
     tm->tileset.size.x = (f32)tm->tileset.texture->width;
     tm->tileset.size.y = (f32)tm->tileset.texture->height;
     tm->tileset.pos.x = (f32)(WINDOW_WIDTH / SCALE) - tm->tileset.size.x - 10;
     tm->tileset.pos.y = (f32)(WINDOW_HEIGHT / SCALE) - tm->tileset.size.y - 10;
 
-    tm->tiles = (Tile*)arena_alloc_aligned(level_mem, sizeof(Tile) * MAX_NUM_TILES, 16);
-    if (!tm->tiles) {
-        util_error("Failed to allocate for map tiles");
+    // Build the tileset lookup table; every tileset cell is solid for now
+    tm->tileset.cols = (u16)(tm->tileset.texture->width / tm->tileset.tile_size);
+    tm->tileset.n_tiles = (u16)(tm->tileset.cols * (tm->tileset.texture->height / tm->tileset.tile_size));
+    tm->tileset.tile_info =
+        (TileInfo*)arena_alloc_tagged(level_mem, sizeof(TileInfo) * tm->tileset.n_tiles, 16, "Tileset");
+    if (!tm->tileset.tile_info) {
+        util_error("Failed to allocate for tileset lookup table");
         return false;
     }
+    for (u16 i = 0; i < tm->tileset.n_tiles; ++i) {
+        tm->tileset.tile_info[i] = (TileInfo){
+            .src =
+                {
+                    .x = (f32)((i % tm->tileset.cols) * tm->tileset.tile_size),
+                    .y = (f32)((i / tm->tileset.cols) * tm->tileset.tile_size),
+                    .width = tm->tileset.tile_size,
+                    .height = tm->tileset.tile_size,
+                },
+            .flags = TILE_FLAG_SOLID,
+        };
+    }
 
-    f32 map_w = state->active_level->tilemap.tiles_wide * state->active_level->tilemap.tile_size;
-    f32 map_h = state->active_level->tilemap.tiles_high * state->active_level->tilemap.tile_size;
-    Vector2 map_centre = {map_w * 0.5f, map_h * 0.5f};
-    state->camera.target = map_centre;
+    if (!chunk_stream_init(&tm->stream, level_mem, CHUNK_STREAM_SLOTS)) {
+        util_error("Failed to init chunk streaming");
+        return false;
+    }
 
-    if (!player_new(level_mem, state)) {
+    // Baking chunks is the fallback for when the shader can't run
+    Tileset* ts = &tm->tileset;
+    bool has_shader =
+        tilemap_shader_init(&tm->shader, CHUNK_STREAM_SLOTS, ts->texture, ts->cols, ts->n_tiles, ts->tile_size);
+    tm->renderer = has_shader ? TILEMAP_RENDER_SHADER : TILEMAP_RENDER_CHUNKS;
+
+    // Everything from here on is runtime state, rebuilt on restart
+    active_level->runtime_marker = arena_get_marker(level_mem);
+    if (!level_new(MAP_COL_TILES, MAP_ROW_TILES)) {
         util_error("Failed to start level");
         return false;
     }
 
-    player_reset(&state->active_level->player);
-    state->camera.target = state->active_level->player.pos;
-
     active_level->is_loaded = true;
 
     return true;
 }
 
-void level_update(void)
+// Restarts the level by discarding all runtime state, leaving the level data and textures untouched.
+bool level_restart(void)
+{
+    arena_set_marker(mem, active_level->runtime_marker);
+
+    if (!init_runtime()) {
+        util_error("Failed to restart level");
+        active_level->is_loaded = false;
+        return false;
+    }
+
+    return true;
+}
+
+// Replaces the world with an empty one of the given size.
+bool level_new(const u16 tiles_wide, const u16 tiles_high)
+{
+    MappedFile image;
+    u32 n_chunks = count_chunks(tiles_wide, tiles_high);
+    if (n_chunks == 0 || !mapped_file_anonymous(&image, n_chunks * sizeof(ChunkData))) {
+        util_error("Failed to create a %ux%u level", tiles_wide, tiles_high);
+        return false;
+    }
+
+    set_image(&image, (ChunkData*)image.data, tiles_wide, tiles_high);
+
+    return level_restart();
+}
+
+// Advances the simulation by one fixed step of dt seconds.
+void level_update(const f32 dt)
 {
-    f32 dt = GetFrameTime();
     player_update(dt);
+    projectiles_update(dt);
+}
+
+// Pages in the chunks around the view and re-bakes or re-uploads any that are new or that the editor has
+// touched. Must be called outside of BeginMode2D, as texture mode resets the camera transform.
+void level_prerender(void)
+{
+    Tilemap* tm = &active_level->tilemap;
+
+    stream_view(false);
+
+    // A hot-reloaded tileset invalidates every baked chunk. Its layout was fixed at init, so a tileset that
+    // changed size will only look right after a restart. The shader samples the tileset as it is.
+    u32 version = assetmgr_get_texture_version(tm->tileset.handle);
+    bool rebake_all = version != tm->tileset.texture_version && tm->renderer == TILEMAP_RENDER_CHUNKS;
+    tm->tileset.texture_version = version;
+
+    for (u16 i = 0; i < tm->stream.n_slots; ++i) {
+        ResidentChunk* rc = &tm->stream.slots[i];
+        if (rc->state != CHUNK_RESIDENT || !(rc->dirty || rebake_all)) {
+            continue;
+        }
+
+        if (tm->renderer == TILEMAP_RENDER_SHADER) {
+            tilemap_shader_upload_chunk(&tm->shader, i, &rc->data);
+            rc->dirty = false;
+        } else {
+            bake_chunk(tm, rc);
+        }
+    }
+}
+
+// True while chunks are still being paged in or waiting to be baked, so frames must keep coming to finish them
+bool level_is_streaming(void)
+{
+    if (!active_level || !active_level->is_loaded) {
+        return false;
+    }
+
+    ChunkStream* cs = &active_level->tilemap.stream;
+    if (cs->pending > 0) {
+        return true;
+    }
+    for (u16 i = 0; i < cs->n_slots; ++i) {
+        if (cs->slots[i].state == CHUNK_RESIDENT && cs->slots[i].dirty) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void level_render(void)
@@ -77,62 +207,162 @@ void level_render(void)
     render_bg();
     render_map();
     player_render();
+    projectiles_render();
 }
 
-bool level_load(void)
+void level_destroy(void)
 {
-    // nfdu8char_t* path;
-    // nfdu8filteritem_t filters[2] = {{"Level data", "bin"}};
-    //
-    // nfdresult_t res = NFD_OpenDialog(&path, filters, 1, "data/");
-    // if (res == NFD_OKAY) {
-    //     i32 bytes_read = 0;
-    //     unsigned char* data = LoadFileData(path, &bytes_read);
-    //     if (!data || bytes_read == 0) {
-    //         util_error("Failed to load file: %s", path);
-    //         return false;
-    //     } else {
-    //         return true;
-    //     }
-    //
-    //     state->active_level = (Level*)data;
-    //
-    //     NFD_FreePathU8(path);
-    //
-    //     return true;
-    // } else if (res == NFD_CANCEL) {
-    // } else {
-    //     util_error("Failed to load file: %s", NFD_GetError());
-    //     return false;
-    // }
+    if (!active_level) {
+        return;
+    }
 
-    return false;
+    chunk_stream_destroy(&active_level->tilemap.stream);
+    tilemap_shader_destroy(&active_level->tilemap.shader);
+    mapped_file_close(&active_level->image);
+
+    active_level = NULL;
+}
+
+// TODO: pick the file with a dialog once nfd is wired up
+bool level_load(void)
+{
+    return level_load_file(LEVEL_FILE);
 }
 
 bool level_save(void)
 {
-    // nfdchar_t* path;
-    // nfdfilteritem_t filters[2] = {{"Level data", "bin"}};
-    //
-    // nfdresult_t res = NFD_SaveDialog(&path, filters, 1, "data/", NULL);
-    // if (res == NFD_OKAY) {
-    //     if (!SaveFileData(path, state->active_level, sizeof(*state->active_level))) {
-    //         util_error("Failed to save file: %s", path);
-    //         return false;
-    //     } else {
-    //         return true;
-    //     }
-    //
-    //     NFD_FreePath(path);
-    //
-    //     return true;
-    // } else if (res == NFD_CANCEL) {
-    // } else {
-    //     util_error("Failed to save file: %s", NFD_GetError());
-    //     return false;
-    // }
+    return level_save_file(LEVEL_FILE);
+}
 
-    return false;
+// Maps the file and, on little-endian hosts, streams chunks straight out of the mapping, so opening a level
+// costs the same regardless of its size. Older versions are decoded into an anonymous image first.
+bool level_load_file(const char* path)
+{
+    Tilemap* tm = &active_level->tilemap;
+
+    MappedFile mf;
+    if (!mapped_file_open(&mf, path)) {
+        util_error("Failed to read level file: %s", path);
+        return false;
+    }
+
+    LevelFileHeader hdr;
+    if (!parse_level_header(mf.data, mf.size, path, &hdr)) {
+        mapped_file_close(&mf);
+        return false;
+    }
+
+    const u8* payload = mf.data + file_payload_offset(&hdr);
+    u32 n_chunks = count_chunks(hdr.tiles_wide, hdr.tiles_high);
+    if (hdr.version >= 3 && can_map_in_place(payload)) {
+        set_image(&mf, (ChunkData*)payload, hdr.tiles_wide, hdr.tiles_high);
+        return level_restart();
+    }
+
+    if (hdr.version < 3 && !decode_tiles(tm, &hdr, payload, hdr.payload_size, NULL)) {
+        util_error("Level tile data is corrupt: %s", path);
+        mapped_file_close(&mf);
+        return false;
+    }
+
+    MappedFile image;
+    if (!mapped_file_anonymous(&image, n_chunks * sizeof(ChunkData))) {
+        util_error("Failed to allocate a %ux%u level", hdr.tiles_wide, hdr.tiles_high);
+        mapped_file_close(&mf);
+        return false;
+    }
+
+    if (hdr.version >= 3) {
+        decode_chunks(payload, n_chunks, (ChunkData*)image.data);
+    } else {
+        decode_tiles(tm, &hdr, payload, hdr.payload_size, (ChunkData*)image.data);
+    }
+    mapped_file_close(&mf);
+
+    set_image(&image, (ChunkData*)image.data, hdr.tiles_wide, hdr.tiles_high);
+    return level_restart();
+}
+
+// Writes the world one chunk at a time, so saving doesn't need a copy of it in memory.
+bool level_save_file(const char* path)
+{
+    Tilemap* tm = &active_level->tilemap;
+    u32 n_chunks = count_chunks(tm->tiles_wide, tm->tiles_high);
+
+    // Overwriting the mapped file would pull the pages out from under the stream, so move to an anonymous
+    // copy of the image first. Resident chunks stay as they are.
+    if (!active_level->image.is_anonymous) {
+        MappedFile image;
+        if (!mapped_file_anonymous(&image, n_chunks * sizeof(ChunkData))) {
+            util_error("Failed to copy level before saving: %s", path);
+            return false;
+        }
+        chunk_stream_wait(&tm->stream);
+        memcpy(image.data, tm->chunk_data, n_chunks * sizeof(ChunkData));
+        chunk_stream_set_source(&tm->stream, (ChunkData*)image.data, n_chunks, true);
+        mapped_file_close(&active_level->image);
+        active_level->image = image;
+        tm->chunk_data = (ChunkData*)image.data;
+    }
+    chunk_stream_write_back(&tm->stream);
+
+    LevelFileHeader hdr = {
+        .version = LEVEL_FILE_VERSION,
+        .tileset_path_len = (u16)strlen(tm->tileset.path),
+        .payload_size = n_chunks * (u32)sizeof(ChunkData),
+    };
+    u8 header[LEVEL_FILE_HEADER_SIZE + 256 + LEVEL_FILE_PAYLOAD_ALIGN] = {0};
+    size_t header_size = file_payload_offset(&hdr);
+    if (header_size > sizeof(header)) {
+        util_error("Tileset path is too long: %s", tm->tileset.path);
+        return false;
+    }
+
+    u8* p = header;
+    memcpy(p, LEVEL_FILE_MAGIC, 4);
+    p = put_u16(p + 4, LEVEL_FILE_VERSION);
+    p = put_u16(p, LEVEL_FILE_NONE);
+    p = put_u16(p, tm->tiles_wide);
+    p = put_u16(p, tm->tiles_high);
+    p = put_u16(p, tm->tile_size);
+    p = put_u16(p, hdr.tileset_path_len);
+    p = put_u32(p, hdr.payload_size);
+    memcpy(p, tm->tileset.path, hdr.tileset_path_len);
+
+    // Written beside the level and renamed over it, so other processes mapping the level keep the old file
+    char tmp_path[LEVEL_PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (i32)sizeof(tmp_path)) {
+        util_error("Level path is too long: %s", path);
+        return false;
+    }
+
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        util_error("Failed to open level file for writing: %s", tmp_path);
+        return false;
+    }
+
+    bool ok = fwrite(header, header_size, 1, f) == 1;
+    for (u32 i = 0; ok && i < n_chunks; ++i) {
+        u8 buf[sizeof(ChunkData)];
+        const u16* src = (const u16*)&tm->chunk_data[i];
+        for (size_t j = 0; j < sizeof(ChunkData) / sizeof(u16); ++j) {
+            put_u16(buf + j * sizeof(u16), src[j]);
+        }
+        ok = fwrite(buf, sizeof(buf), 1, f) == 1;
+    }
+    if (!ok) {
+        fclose(f);
+        remove(tmp_path);
+    } else {
+        ok = mapped_file_replace(f, tmp_path, path);
+    }
+
+    if (!ok) {
+        util_error("Failed to write level file: %s", path);
+    }
+
+    return ok;
 }
 
 bool level_process_shared_events(void)
@@ -140,6 +370,9 @@ bool level_process_shared_events(void)
     if (input_is_key_pressed(&state->input.kb, KB_F3)) {
         state->debug = !state->debug;
     }
+    if (input_is_key_pressed(&state->input.kb, KB_F5)) {
+        toggle_renderer(&active_level->tilemap);
+    }
     return false;
 }
 
@@ -185,17 +418,508 @@ Vector2 worldp_to_gridp(const Vector2 p, const u8 tile_size)
     };
 }
 
+// Returns the world space rectangle visible through the camera.
+Rectangle camera_get_view_rect(Camera2D* cam, const f32 screen_w, const f32 screen_h)
+{
+    Vector2 top_left = screenp_to_worldp((Vector2){0.0f, 0.0f}, cam, screen_w, screen_h);
+    Vector2 bottom_right = screenp_to_worldp((Vector2){screen_w, screen_h}, cam, screen_w, screen_h);
+
+    return (Rectangle){
+        .x = top_left.x,
+        .y = top_left.y,
+        .width = bottom_right.x - top_left.x,
+        .height = bottom_right.y - top_left.y,
+    };
+}
+
+// Returns the span of grid cells that the world space rectangle r overlaps, clamped to the map.
+TileSpan tilemap_get_overlapping_tiles(const Tilemap* tm, const Rectangle r)
+{
+    i32 col_start = (i32)floorf(r.x / tm->tile_size);
+    i32 row_start = (i32)floorf(r.y / tm->tile_size);
+    i32 col_end = (i32)ceilf((r.x + r.width) / tm->tile_size);
+    i32 row_end = (i32)ceilf((r.y + r.height) / tm->tile_size);
+
+    // Clamp to legal indices
+    if (col_start < 0) col_start = 0;
+    if (row_start < 0) row_start = 0;
+    if (col_end > tm->tiles_wide) col_end = tm->tiles_wide;
+    if (row_end > tm->tiles_high) row_end = tm->tiles_high;
+
+    // Rectangle lies entirely off the map
+    if (col_end < col_start) col_end = col_start;
+    if (row_end < row_start) row_end = row_start;
+
+    return (TileSpan){
+        .col_start = (u16)col_start,
+        .col_end = (u16)col_end,
+        .row_start = (u16)row_start,
+        .row_end = (u16)row_end,
+    };
+}
+
+// Flags the chunk containing the tile at (col, row) for re-baking.
+void tilemap_mark_dirty(Tilemap* tm, const u32 col, const u32 row)
+{
+    if (col >= tm->tiles_wide || row >= tm->tiles_high) {
+        return;
+    }
+
+    ResidentChunk* rc = chunk_stream_get(&tm->stream, chunk_index(tm, col, row));
+    if (rc) {
+        rc->dirty = true;
+    }
+}
+
+// Writes a tile, keeping the chunk's solid bits and baked texture in sync. All tile edits should go through
+// here. Only resident chunks can be edited; the edit reaches the level image when the chunk is evicted.
+void tilemap_set_tile(Tilemap* tm, const u32 col, const u32 row, const TileId id)
+{
+    if (col >= tm->tiles_wide || row >= tm->tiles_high) {
+        return;
+    }
+
+    ResidentChunk* rc = chunk_stream_get(&tm->stream, chunk_index(tm, col, row));
+    if (!rc) {
+        return;
+    }
+
+    chunk_set_tile(tm, &rc->data, col % CHUNK_TILES, row % CHUNK_TILES, id);
+    rc->modified = true;
+
+    // The shader only needs the one texel; a chunk that's already dirty gets all of its tiles uploaded anyway
+    if (tm->renderer == TILEMAP_RENDER_SHADER && !rc->dirty) {
+        u16 slot = (u16)(rc - tm->stream.slots);
+        tilemap_shader_upload_tile(&tm->shader, slot, (u16)(col % CHUNK_TILES), (u16)(row % CHUNK_TILES), id);
+    } else {
+        rc->dirty = true;
+    }
+}
+
+// Returns the column of the first solid cell in [col_start, col_end) of row, scanning left to right, or
+// right to left when reverse is set. Returns -1 if the span has no solid cells. Chunks that aren't resident
+// count as solid, so nothing can move into parts of the world that haven't been paged in yet.
+i32 tilemap_find_solid(const Tilemap* tm, const u16 row, const u16 col_start, const u16 col_end, const bool reverse)
+{
+    if (col_start >= col_end) {
+        return -1;
+    }
+
+    u32 first_chunk = col_start / CHUNK_TILES;
+    u32 last_chunk = (u32)(col_end - 1) / CHUNK_TILES;
+    u32 chunk_row = (u32)(row / CHUNK_TILES) * tm->chunks_wide;
+
+    for (u32 i = 0; i <= last_chunk - first_chunk; ++i) {
+        u32 c = reverse ? last_chunk - i : first_chunk + i;
+
+        ResidentChunk* rc = chunk_stream_get(&tm->stream, chunk_row + c);
+        u32 bits = rc ? rc->data.solid[row % CHUNK_TILES] : 0xffffU;
+
+        u32 lo = c == first_chunk ? col_start % CHUNK_TILES : 0;
+        u32 hi = c == last_chunk ? (u32)(col_end - 1) % CHUNK_TILES : CHUNK_TILES - 1;
+        bits &= ((2U << hi) - 1) & ~((1U << lo) - 1);
+        if (!bits) {
+            continue;
+        }
+
+        if (reverse) {
+            return (i32)(c * CHUNK_TILES + 31 - (u32)__builtin_clz(bits));
+        }
+        return (i32)(c * CHUNK_TILES + (u32)__builtin_ctz(bits));
+    }
+
+    return -1;
+}
+
+bool tilemap_is_solid(const Tilemap* tm, const u16 col, const u16 row)
+{
+    return tilemap_find_solid(tm, row, col, (u16)(col + 1), false) >= 0;
+}
+
+// Maps a tileset source rectangle to its tile ID, or TILE_EMPTY if it lies outside the tileset.
+TileId tileset_get_tile_id(const Tileset* ts, const Rectangle src)
+{
+    if (src.x < 0.0f || src.y < 0.0f) {
+        return TILE_EMPTY;
+    }
+
+    u32 col = (u32)(src.x / ts->tile_size);
+    u32 row = (u32)(src.y / ts->tile_size);
+    u32 idx = row * ts->cols + col;
+    if (col >= ts->cols || idx >= ts->n_tiles) {
+        return TILE_EMPTY;
+    }
+
+    return (TileId)(idx + 1);
+}
+
 // ································································································
 
+static bool init_runtime(void)
+{
+    // Spawn the player in the middle of the map
+    Tilemap* tm = &active_level->tilemap;
+    f32 map_w = tm->tiles_wide * tm->tile_size;
+    f32 map_h = tm->tiles_high * tm->tile_size;
+    state->camera.target = (Vector2){map_w * 0.5f, map_h * 0.5f};
+
+    if (!player_new(mem, state)) {
+        return false;
+    }
+
+    if (!projectiles_init(mem, state, MAX_PROJECTILES)) {
+        return false;
+    }
+
+    state->camera.target = active_level->player->pos;
+    state->sim_accumulator = 0.0f;
+
+    // Don't start simulating until the chunks around the player are in
+    stream_view(true);
+
+    return true;
+}
+
+// Requests every chunk overlapping the view, plus LEVEL_STREAM_MARGIN chunks around it. Blocks until they're
+// all resident when wait is set.
+static void stream_view(const bool wait)
+{
+    Tilemap* tm = &active_level->tilemap;
+    chunk_stream_begin_frame(&tm->stream);
+
+    Rectangle view = camera_get_view_rect(&state->camera, (f32)GetScreenWidth(), (f32)GetScreenHeight());
+    TileSpan span = tilemap_get_overlapping_tiles(tm, view);
+    u32 col_start = max(span.col_start / CHUNK_TILES, LEVEL_STREAM_MARGIN) - LEVEL_STREAM_MARGIN;
+    u32 row_start = max(span.row_start / CHUNK_TILES, LEVEL_STREAM_MARGIN) - LEVEL_STREAM_MARGIN;
+    u32 col_end = min((u32)(span.col_end + CHUNK_TILES - 1) / CHUNK_TILES + LEVEL_STREAM_MARGIN, tm->chunks_wide);
+    u32 row_end = min((u32)(span.row_end + CHUNK_TILES - 1) / CHUNK_TILES + LEVEL_STREAM_MARGIN, tm->chunks_high);
+
+    for (u32 row = row_start; row < row_end; ++row) {
+        for (u32 col = col_start; col < col_end; ++col) {
+            if (!chunk_stream_request(&tm->stream, row * tm->chunks_wide + col)) {
+                break;
+            }
+        }
+    }
+
+    if (wait) {
+        chunk_stream_wait(&tm->stream);
+    }
+    state->stats.chunks_resident = tm->stream.n_resident;
+}
+
+// Makes image the level's world, taking ownership of it, and drops every resident chunk.
+static void set_image(MappedFile* image, ChunkData* chunks, const u16 tiles_wide, const u16 tiles_high)
+{
+    Tilemap* tm = &active_level->tilemap;
+
+    // Waits for the worker, so the old image can go once this returns
+    chunk_stream_set_source(&tm->stream, chunks, count_chunks(tiles_wide, tiles_high), false);
+    mapped_file_close(&active_level->image);
+    active_level->image = *image;
+
+    tm->chunk_data = chunks;
+    tm->tiles_wide = tiles_wide;
+    tm->tiles_high = tiles_high;
+    tm->chunks_wide = (u16)((tiles_wide + CHUNK_TILES - 1) / CHUNK_TILES);
+    tm->chunks_high = (u16)((tiles_high + CHUNK_TILES - 1) / CHUNK_TILES);
+}
+
+static u32 chunk_index(const Tilemap* tm, const u32 col, const u32 row)
+{
+    return (row / CHUNK_TILES) * tm->chunks_wide + col / CHUNK_TILES;
+}
+
+// Writes a tile at (col, row) within the chunk and updates its solid bit.
+static void chunk_set_tile(const Tilemap* tm, ChunkData* chunk, const u32 col, const u32 row, const TileId id)
+{
+    chunk->tiles[row * CHUNK_TILES + col] = id;
+
+    u16 bit = (u16)(1U << col);
+    if (id != TILE_EMPTY && id <= tm->tileset.n_tiles && (tilemap_get_tile_info(tm, id)->flags & TILE_FLAG_SOLID)) {
+        chunk->solid[row] |= bit;
+    } else {
+        chunk->solid[row] &= (u16)~bit;
+    }
+}
+
+static u8* put_u16(u8* p, const u16 v)
+{
+    p[0] = (u8)(v & 0xff);
+    p[1] = (u8)(v >> 8);
+    return p + 2;
+}
+
+static u8* put_u32(u8* p, const u32 v)
+{
+    p = put_u16(p, (u16)(v & 0xffff));
+    return put_u16(p, (u16)(v >> 16));
+}
+
+static u16 get_u16(const u8* p)
+{
+    return (u16)(p[0] | (p[1] << 8));
+}
+
+static u32 get_u32(const u8* p)
+{
+    return (u32)get_u16(p) | ((u32)get_u16(p + 2) << 16);
+}
+
+// Decodes a version 1 or 2 payload, rejecting out of range tile IDs and size mismatches. Tiles are only
+// written when out is set, so a corrupt file can be rejected before anything is allocated for it.
+static bool decode_tiles(
+    const Tilemap* tm, const LevelFileHeader* hdr, const u8* payload, const u32 size, ChunkData* out)
+{
+    u32 n_tiles = (u32)(hdr->tiles_wide * hdr->tiles_high);
+    u16 chunks_wide = (u16)((hdr->tiles_wide + CHUNK_TILES - 1) / CHUNK_TILES);
+    bool rle = hdr->flags & LEVEL_FILE_RLE;
+    u32 tiles_size = size;
+    u32 cell = 0;
+
+    // Version 2 raw payloads carry a solid bitset after the tiles, which is rebuilt here instead
+    if (!rle) {
+        tiles_size = n_tiles * (u32)sizeof(TileId);
+        if (hdr->version < 2 ? size != tiles_size : size < tiles_size) {
+            return false;
+        }
+    }
+
+    for (u32 i = 0; i + (rle ? 4 : 2) <= tiles_size;) {
+        u32 run = 1;
+        if (rle) {
+            run = get_u16(payload + i);
+            i += 2;
+        }
+        TileId id = get_u16(payload + i);
+        i += 2;
+
+        if (id > tm->tileset.n_tiles || run > n_tiles - cell) {
+            return false;
+        }
+        for (u32 j = 0; j < run; ++j, ++cell) {
+            if (out) {
+                u32 col = cell % hdr->tiles_wide;
+                u32 row = cell / hdr->tiles_wide;
+                ChunkData* chunk = &out[(row / CHUNK_TILES) * chunks_wide + col / CHUNK_TILES];
+                chunk_set_tile(tm, chunk, col % CHUNK_TILES, row % CHUNK_TILES, id);
+            }
+        }
+    }
+
+    return cell == n_tiles;
+}
+
+// Byte swapping copy of a version 3 payload for hosts that can't map it in place. ChunkData is nothing but
+// u16s, so it can be converted as one flat array.
+static void decode_chunks(const u8* payload, const size_t n_chunks, ChunkData* out)
+{
+    u16* dst = (u16*)out;
+    for (size_t i = 0; i < n_chunks * sizeof(ChunkData) / sizeof(u16); ++i) {
+        dst[i] = get_u16(payload + i * sizeof(u16));
+    }
+}
+
+static size_t file_payload_offset(const LevelFileHeader* hdr)
+{
+    size_t offset = LEVEL_FILE_HEADER_SIZE + (size_t)hdr->tileset_path_len;
+    return hdr->version < 2 ? offset : align_forward(offset, LEVEL_FILE_PAYLOAD_ALIGN);
+}
+
+// Returns 0 if the world would be too large to describe in a level file.
+static u32 count_chunks(const u16 tiles_wide, const u16 tiles_high)
+{
+    u64 chunks_wide = (u64)(tiles_wide + CHUNK_TILES - 1) / CHUNK_TILES;
+    u64 chunks_high = (u64)(tiles_high + CHUNK_TILES - 1) / CHUNK_TILES;
+    u64 n_chunks = chunks_wide * chunks_high;
+    return n_chunks * sizeof(ChunkData) > UINT32_MAX ? 0 : (u32)n_chunks;
+}
+
+static bool parse_level_header(const u8* data, const size_t size, const char* path, LevelFileHeader* hdr)
+{
+    Tilemap* tm = &active_level->tilemap;
+
+    if (size < LEVEL_FILE_HEADER_SIZE || memcmp(data, LEVEL_FILE_MAGIC, 4) != 0) {
+        util_error("Not a level file: %s", path);
+        return false;
+    }
+
+    *hdr = (LevelFileHeader){
+        .version = get_u16(data + 4),
+        .flags = get_u16(data + 6),
+        .tiles_wide = get_u16(data + 8),
+        .tiles_high = get_u16(data + 10),
+        .tile_size = get_u16(data + 12),
+        .tileset_path_len = get_u16(data + 14),
+        .payload_size = get_u32(data + 16),
+    };
+    memcpy(hdr->magic, data, 4);
+
+    if (hdr->version < 1 || hdr->version > LEVEL_FILE_VERSION) {
+        util_error("Unsupported level file version %u: %s", hdr->version, path);
+        return false;
+    }
+    u32 n_chunks = count_chunks(hdr->tiles_wide, hdr->tiles_high);
+    if (n_chunks == 0 || hdr->tile_size != tm->tile_size) {
+        util_error("Unsupported level dimensions %ux%u@%u: %s", hdr->tiles_wide, hdr->tiles_high,
+            hdr->tile_size, path);
+        return false;
+    }
+    if (file_payload_offset(hdr) + hdr->payload_size > size) {
+        util_error("Level file is truncated: %s", path);
+        return false;
+    }
+    if (hdr->version >= 3 && hdr->payload_size != n_chunks * sizeof(ChunkData)) {
+        util_error("Level chunk data is corrupt: %s", path);
+        return false;
+    }
+
+    const char* tileset_path = (const char*)data + LEVEL_FILE_HEADER_SIZE;
+    if (hdr->tileset_path_len != strlen(tm->tileset.path) ||
+        strncmp(tileset_path, tm->tileset.path, hdr->tileset_path_len) != 0) {
+        util_error("Level uses an unsupported tileset: %.*s", (int)hdr->tileset_path_len, tileset_path);
+        return false;
+    }
+
+    return true;
+}
+
+// Version 3 payloads match ChunkData in memory, byte order permitting.
+static bool can_map_in_place(const u8* payload)
+{
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    return ((uintptr_t)payload % _Alignof(ChunkData)) == 0;
+#else
+    (void)payload;
+    return false;
+#endif
+}
+
 static void render_bg(void)
 {
 }
 
 static void render_map(void)
 {
-    for (size_t i = 0; i < MAX_NUM_TILES; ++i) {
-        Tile tile = active_level->tilemap.tiles[i];
+    Tilemap* tm = &active_level->tilemap;
+    Rectangle view = camera_get_view_rect(&state->camera, (f32)GetScreenWidth(), (f32)GetScreenHeight());
+    TileSpan span = tilemap_get_overlapping_tiles(tm, view);
+    f32 chunk_px = (f32)(CHUNK_TILES * tm->tile_size);
+
+    if (tm->renderer == TILEMAP_RENDER_SHADER) {
+        render_map_shader(tm, span);
+        return;
+    }
+
+    u16 chunk_col_end = (u16)((span.col_end + CHUNK_TILES - 1) / CHUNK_TILES);
+    u16 chunk_row_end = (u16)((span.row_end + CHUNK_TILES - 1) / CHUNK_TILES);
+
+    for (u16 row = span.row_start / CHUNK_TILES; row < chunk_row_end; ++row) {
+        for (u16 col = span.col_start / CHUNK_TILES; col < chunk_col_end; ++col) {
+            ResidentChunk* rc = chunk_stream_get(&tm->stream, (u32)(row * tm->chunks_wide + col));
+            if (!rc || rc->empty || rc->dirty) {
+                continue;
+            }
 
-        DrawTexturePro(*active_level->tilemap.tileset.texture, tile.src, tile.dst, (Vector2){0, 0}, 0.0f, WHITE);
+            // Render textures are stored upside down
+            Rectangle src = {0.0f, 0.0f, chunk_px, -chunk_px};
+            Rectangle dst = {(f32)col * chunk_px, (f32)row * chunk_px, chunk_px, chunk_px};
+            draw_sprite(DRAW_LAYER_MAP, &rc->target.texture, src, dst, WHITE);
+            state->stats.chunks_drawn++;
+        }
     }
 }
+
+// Points the shader's slot table at the resident chunks in view and draws them all with one quad.
+static void render_map_shader(Tilemap* tm, const TileSpan span)
+{
+    u16 col_start = span.col_start / CHUNK_TILES;
+    u16 row_start = span.row_start / CHUNK_TILES;
+    u16 cols = (u16)min((u32)(span.col_end + CHUNK_TILES - 1) / CHUNK_TILES - col_start, TILEMAP_SHADER_MAX_WINDOW);
+    u16 rows = (u16)min((u32)(span.row_end + CHUNK_TILES - 1) / CHUNK_TILES - row_start, TILEMAP_SHADER_MAX_WINDOW);
+    f32 chunk_px = (f32)(CHUNK_TILES * tm->tile_size);
+
+    for (u16 row = 0; row < rows; ++row) {
+        for (u16 col = 0; col < cols; ++col) {
+            u32 chunk = (u32)(row_start + row) * tm->chunks_wide + col_start + col;
+            ResidentChunk* rc = chunk_stream_get(&tm->stream, chunk);
+
+            // Chunks whose tiles haven't been uploaded yet stay blank for a frame
+            u16 slot = rc && !rc->dirty ? (u16)(rc - tm->stream.slots + 1) : 0;
+            tm->shader.slots[row * cols + col] = slot;
+            state->stats.chunks_drawn += slot != 0;
+        }
+    }
+
+    Rectangle dst = {(f32)col_start * chunk_px, (f32)row_start * chunk_px, (f32)cols * chunk_px, (f32)rows * chunk_px};
+    // The quad needs its shader, so it can't go through the draw list. What's queued below it goes first.
+    draw_list_flush();
+    tilemap_shader_draw(&tm->shader, dst, cols, rows);
+}
+
+// Switches between drawing with the shader and baking chunks. Every resident chunk has to be baked or
+// uploaded afresh, as the other renderer has been keeping them up to date.
+static void toggle_renderer(Tilemap* tm)
+{
+    if (tm->renderer == TILEMAP_RENDER_CHUNKS && !IsShaderValid(tm->shader.shader)) {
+        util_warn("Tilemap shader is unavailable");
+        return;
+    }
+
+    tm->renderer = tm->renderer == TILEMAP_RENDER_SHADER ? TILEMAP_RENDER_CHUNKS : TILEMAP_RENDER_SHADER;
+    for (u16 i = 0; i < tm->stream.n_slots; ++i) {
+        tm->stream.slots[i].dirty = true;
+    }
+}
+
+static void bake_chunk(Tilemap* tm, ResidentChunk* rc)
+{
+    u16 col_start = (u16)((rc->chunk % tm->chunks_wide) * CHUNK_TILES);
+    u16 row_start = (u16)((rc->chunk / tm->chunks_wide) * CHUNK_TILES);
+    u16 col_end = (u16)min(col_start + CHUNK_TILES, tm->tiles_wide);
+    u16 row_end = (u16)min(row_start + CHUNK_TILES, tm->tiles_high);
+    f32 origin_x = (f32)(col_start * tm->tile_size);
+    f32 origin_y = (f32)(row_start * tm->tile_size);
+
+    if (rc->target.id == 0) {
+        i32 chunk_px = CHUNK_TILES * tm->tile_size;
+        rc->target = LoadRenderTexture(chunk_px, chunk_px);
+        if (!IsRenderTextureValid(rc->target)) {
+            // Drawn as empty rather than retried every frame. The next load or edit of the chunk tries again.
+            util_error("Failed to create chunk render texture");
+            UnloadRenderTexture(rc->target);
+            rc->target = (RenderTexture2D){0};
+            rc->empty = true;
+            rc->dirty = false;
+            return;
+        }
+    }
+
+    rc->empty = true;
+
+    BeginTextureMode(rc->target);
+    {
+        ClearBackground(BLANK);
+
+        for (u16 row = row_start; row < row_end; ++row) {
+            for (u16 col = col_start; col < col_end; ++col) {
+                // Mapped levels aren't validated up front, so unknown IDs are skipped here instead
+                TileId id = rc->data.tiles[(row - row_start) * CHUNK_TILES + (col - col_start)];
+                if (id == TILE_EMPTY || id > tm->tileset.n_tiles) {
+                    continue;
+                }
+
+                Rectangle dst = tilemap_get_tile_dst(tm, col, row);
+                dst.x -= origin_x;
+                dst.y -= origin_y;
+                DrawTexturePro(
+                    *tm->tileset.texture, tilemap_get_tile_info(tm, id)->src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+                rc->empty = false;
+            }
+        }
+    }
+    EndTextureMode();
+
+    rc->dirty = false;
+    state->stats.chunks_baked++;
+}
@@ -2,18 +2,60 @@
 #define LEVEL_H_
 
 #include "arena.h"
+#include "chunk_stream.h"
+#include "mapped_file.h"
 #include "player.h"
 #include "raylib.h"
 #include "state.h"
+#include "tilemap_shader.h"
 #include "utils.h"
 #include <stdbool.h>
 
 #define SCALE 2.0f
 #define MAX_ZOOM 5.0f
 #define MAP_TILE_SIZE 18
+
+// Size of a new, empty level. Loaded levels take their size from the file.
 #define MAP_COL_TILES 80
 #define MAP_ROW_TILES 50
-#define MAX_NUM_TILES (MAP_ROW_TILES * MAP_COL_TILES)
+
+// Chunks beyond the edge of the view that are kept paged in, so scrolling doesn't reveal holes.
+#define LEVEL_STREAM_MARGIN 1
+
+#define LEVEL_TILESET_PATH "assets/textures/tilemap.png"
+#define LEVEL_PATH_MAX 512
+#define LEVEL_FILE "data/level.bin"
+
+// On-disk level format, all fields little-endian:
+//   LevelFileHeader
+//   tileset path, tileset_path_len bytes, not NUL-terminated, zero padded to LEVEL_FILE_PAYLOAD_ALIGN
+//   payload, payload_size bytes: one ChunkData per chunk in row-major chunk order, covering
+//   ceil(tiles_wide / CHUNK_TILES) x ceil(tiles_high / CHUNK_TILES) chunks
+// Payloads are laid out exactly like ChunkData in memory, so on little-endian hosts the file is mapped and
+// chunks are paged in straight from it. Older versions are decoded into an anonymous mapping on load:
+//   version 1: no path padding; tiles_wide * tiles_high u16 tile IDs in row-major order, or with
+//              LEVEL_FILE_RLE set, a sequence of (u16 run length, u16 tile ID) pairs
+//   version 2: as version 1 but with path padding, and raw tile IDs followed by a row-major solid bitset
+#define LEVEL_FILE_MAGIC "FFLV"
+#define LEVEL_FILE_VERSION 3
+#define LEVEL_FILE_HEADER_SIZE 20
+#define LEVEL_FILE_PAYLOAD_ALIGN 16
+
+typedef enum {
+    LEVEL_FILE_NONE = 0U,
+    LEVEL_FILE_RLE = 1U << 0,
+} LevelFileFlags;
+
+typedef struct {
+    char magic[4];
+    u16 version;
+    u16 flags;
+    u16 tiles_wide;
+    u16 tiles_high;
+    u16 tile_size;
+    u16 tileset_path_len;
+    u32 payload_size;
+} LevelFileHeader;
 
 #define DEBUG_UI_LINE_THICKNESS 3.0f
 #define MAX_BRUSH_SIZE (MAP_TILE_SIZE * 20)
@@ -23,21 +65,42 @@ extern const Color paleblue;
 extern const Color paleblue_d;
 extern const Color paleblue_des;
 
+#define TILE_EMPTY ((TileId)0)
+
+typedef enum {
+    TILE_FLAG_NONE = 0U,
+    TILE_FLAG_SOLID = 1U << 0,
+} TileFlags;
+
 typedef struct {
     Rectangle src;
-    Rectangle dst;
-    bool solid;
-} Tile;
+    u8 flags;
+} TileInfo;
+
+// Half-open range of grid cells [col_start, col_end) x [row_start, row_end).
+typedef struct {
+    u16 col_start;
+    u16 col_end;
+    u16 row_start;
+    u16 row_end;
+} TileSpan;
 
 typedef struct {
     Vector2 pos;
     Vector2 size;
     Rectangle src;
+    TileId tile_id;
     bool is_set;
 } Brush;
 
 typedef struct {
+    const char* path;
     Texture2D* texture;
+    TextureHandle handle;
+    u32 texture_version; // Version of texture the resident chunks were baked from
+    TileInfo* tile_info; // Indexed by TileId - 1
+    u16 cols;
+    u16 n_tiles;
     Vector2 hovered_tile;
     Vector2 pos;
     Vector2 size;
@@ -45,33 +108,79 @@ typedef struct {
     bool active;
 } Tileset;
 
+typedef enum {
+    TILEMAP_RENDER_CHUNKS, // Resident chunks are baked into render textures, one quad each
+    TILEMAP_RENDER_SHADER, // The view is one quad, with tiles looked up per pixel; see tilemap_shader.h
+} TilemapRenderer;
+
 typedef struct {
     u16 tiles_wide;
     u16 tiles_high;
     u16 tile_size;
+    u16 chunks_wide;
+    u16 chunks_high;
     Brush brush;
     Tileset tileset;
-    Tile* tiles;
+    ChunkData* chunk_data; // The whole world, chunks_wide * chunks_high chunks; only touched via stream
+    ChunkStream stream;    // Chunks near the camera; collision and rendering only ever see these
+    TilemapRenderer renderer;
+    TilemapShader shader;
 } Tilemap;
 
+// Level memory is laid out as the level data (tilemap, tileset tables, chunk stream) followed by runtime
+// state (player, projectiles). Restarting rolls the arena back to runtime_marker and rebuilds only the
+// latter. The world itself lives in image, either a private mapping of the level file or an anonymous
+// mapping for new and decoded levels; evicted edits are written back to it copy-on-write.
 typedef struct Level {
     Texture2D* bg_texture;
     Tilemap tilemap;
-    Player player;
+    MappedFile image;
+    Player* player;
+    ArenaMarker runtime_marker;
     // colliders;
     bool is_loaded;
 } Level;
 
 bool level_init(MemoryArena* level_mem, GameState* state);
-void level_update(void);
+bool level_restart(void);
+bool level_new(const u16 tiles_wide, const u16 tiles_high);
+void level_update(const f32 dt);
+void level_prerender(void);
 void level_render(void);
+bool level_is_streaming(void);
+void level_destroy(void);
 bool level_load(void);
 bool level_save(void);
+bool level_load_file(const char* path);
+bool level_save_file(const char* path);
 
 bool level_process_shared_events(void);
 
 Vector2 screenp_to_worldp(const Vector2 spos, Camera2D* cam, const f32 screen_w, const f32 screen_h);
 Vector2 screenp_to_gridp(const Vector2 p, const u8 tile_size);
 Vector2 worldp_to_gridp(const Vector2 p, const u8 tile_size);
+Rectangle camera_get_view_rect(Camera2D* cam, const f32 screen_w, const f32 screen_h);
+
+TileSpan tilemap_get_overlapping_tiles(const Tilemap* tm, const Rectangle r);
+void tilemap_mark_dirty(Tilemap* tm, const u32 col, const u32 row);
+void tilemap_set_tile(Tilemap* tm, const u32 col, const u32 row, const TileId id);
+i32 tilemap_find_solid(const Tilemap* tm, const u16 row, const u16 col_start, const u16 col_end, const bool reverse);
+bool tilemap_is_solid(const Tilemap* tm, const u16 col, const u16 row);
+TileId tileset_get_tile_id(const Tileset* ts, const Rectangle src);
+
+static inline const TileInfo* tilemap_get_tile_info(const Tilemap* tm, const TileId id)
+{
+    return &tm->tileset.tile_info[id - 1];
+}
+
+static inline Rectangle tilemap_get_tile_dst(const Tilemap* tm, const u16 col, const u16 row)
+{
+    return (Rectangle){
+        .x = (f32)(col * tm->tile_size),
+        .y = (f32)(row * tm->tile_size),
+        .width = tm->tile_size,
+        .height = tm->tile_size,
+    };
+}
 
 #endif // !LEVEL_H_
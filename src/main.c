@@ -1,12 +1,26 @@
 #include "arena.h"
 #include "game.h"
+#include "utils.h"
+#include <string.h>
 
-int main(void)
+int main(int argc, char** argv)
 {
+    // e.g. make run ARGS="--hot-reload --low-res"
+    GameOptions options = {0};
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--hot-reload") == 0) {
+            options.hot_reload = true;
+        } else if (strcmp(argv[i], "--low-res") == 0) {
+            options.low_res = true;
+        } else {
+            util_warn("Unknown option: %s", argv[i]);
+        }
+    }
+
     MemoryArena game_mem;
-    arena_init(&game_mem, 1 * MB);
+    arena_init_virtual(&game_mem, 1 * GB);
 
-    if (!game_init(&game_mem)) {
+    if (!game_init(&game_mem, &options)) {
         util_fatal("Failed to init game.");
     }
 
@@ -21,7 +21,7 @@ static void quit_fn(void);
 void main_menu_init(GameState* game_state)
 {
     state = game_state;
-    Font* font = assetmgr_get_font("main");
+    Font* font = assetmgr_get_font(state->ui_font);
 
     u16 text_height = (u16)(MAIN_MENU_N_ITEMS * UI_MENU_ITEM_SIZE + UI_HEADER_SIZE);
     u16 starty = (u16)((f32)GetScreenHeight() * 0.5f - text_height * 0.5f + UI_HEADER_SIZE);
@@ -63,7 +63,7 @@ void main_menu_update(void)
 
 void main_menu_render(void)
 {
-    Font* font = assetmgr_get_font("main");
+    Font* font = assetmgr_get_font(state->ui_font);
 
     BeginDrawing();
     {
@@ -0,0 +1,138 @@
+// Kept out of mapped_file.h so the platform headers don't leak into files that include raylib.
+#define _DEFAULT_SOURCE
+
+#include "mapped_file.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool mapped_file_open(MappedFile* mf, const char* path)
+{
+    *mf = (MappedFile){0};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return false;
+    }
+
+    // The view keeps the mapping object alive
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        return false;
+    }
+
+    mf->data = (u8*)data;
+    mf->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping holds its own reference to the file
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    mf->data = (u8*)data;
+    mf->size = (size_t)st.st_size;
+#endif
+
+    return true;
+}
+
+bool mapped_file_anonymous(MappedFile* mf, const size_t size)
+{
+    *mf = (MappedFile){0};
+
+#ifdef _WIN32
+    void* data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!data) {
+        return false;
+    }
+#else
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    mf->data = (u8*)data;
+    mf->size = size;
+    mf->is_anonymous = true;
+
+    return true;
+}
+
+void mapped_file_close(MappedFile* mf)
+{
+    if (!mf->data) {
+        return;
+    }
+
+#ifdef _WIN32
+    if (mf->is_anonymous) {
+        VirtualFree(mf->data, 0, MEM_RELEASE);
+    } else {
+        UnmapViewOfFile(mf->data);
+    }
+#else
+    munmap(mf->data, mf->size);
+#endif
+
+    *mf = (MappedFile){0};
+}
+
+// Closes f, which was written to tmp_path, once its data is on disk, and then renames it over path. Anyone
+// with path mapped keeps the old file, and path is never left half written. Returns false, with tmp_path
+// removed, if any step fails.
+bool mapped_file_replace(FILE* f, const char* tmp_path, const char* path)
+{
+    bool ok = fflush(f) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && rename(tmp_path, path) == 0;
+#endif
+
+    if (!ok) {
+        remove(tmp_path);
+    }
+    return ok;
+}
@@ -0,0 +1,23 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// A private, copy-on-write mapping of a whole file. Pages are shared with the page cache until written to,
+// at which point the writer gets its own copy; the file on disk is never modified. Anonymous mappings have
+// no file behind them and start out zeroed, so callers can treat both the same way.
+typedef struct {
+    u8* data;
+    size_t size;
+    bool is_anonymous;
+} MappedFile;
+
+bool mapped_file_open(MappedFile* mf, const char* path);
+bool mapped_file_anonymous(MappedFile* mf, const size_t size);
+void mapped_file_close(MappedFile* mf);
+bool mapped_file_replace(FILE* f, const char* tmp_path, const char* path);
+
+#endif // !MAPPED_FILE_H_
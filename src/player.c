@@ -1,28 +1,29 @@
 #include "player.h"
+#include "draw_list.h"
 #include "gfx.h"
 #include "level.h"
+#include "projectile.h"
 #include "raylib.h"
 
 static GameState* state;
 static Player* player;
-static Bullet bullets[MAX_BULLETS];
-static size_t n_bullets;
-static size_t live_bullets[MAX_BULLETS];
-static size_t n_live_bullets;
 
-static inline void get_overlapping_tiles(Rectangle r, size_t* out_first, size_t* out_last);
+static inline Vector2 lerpv(const Vector2 a, const Vector2 b, const f32 t);
+static bool sweep_x(Tilemap* tm, const Rectangle box, const bool moving_right, Rectangle* out_hit);
+static bool sweep_y(Tilemap* tm, const Rectangle box, const bool moving_down, Rectangle* out_hit);
 
 bool player_new(MemoryArena* level_mem, GameState* game_state)
 {
     state = game_state;
 
-    player = (Player*)arena_alloc_aligned(level_mem, sizeof(Player), 16);
+    player = (Player*)arena_alloc_tagged(level_mem, sizeof(Player), 16, "Player");
     if (!player) {
         util_error("Failed to create player");
         return false;
     }
 
     player_reset(player);
+    state->active_level->player = player;
     state->camera.target = player->pos;
 
     return true;
@@ -32,14 +33,17 @@ void player_update(float dt)
 {
     Tilemap* tm = &state->active_level->tilemap;
 
+    player->prev_pos = player->pos;
+
     // TODO: should be reset for animation/movement frames but not for bullet initial dir
     // player->dir = DIRECTION_NONE;
 
-    if (input_is_key_down(&state->input.kb, KB_A) || input_gamepad_button_down(3, GAMEPAD_BUTTON_LEFT_FACE_LEFT)) {
+    if (input_is_key_down(&state->input.kb, KB_A) ||
+        input_is_pad_down(&state->input.pad, GAMEPAD_BUTTON_LEFT_FACE_LEFT)) {
         player->vel.x = -PLAYER_SPEED;
         player->dir = DIRECTION_LEFT;
     } else if (input_is_key_down(&state->input.kb, KB_D) ||
-               input_gamepad_button_down(3, GAMEPAD_BUTTON_LEFT_FACE_RIGHT)) {
+               input_is_pad_down(&state->input.pad, GAMEPAD_BUTTON_LEFT_FACE_RIGHT)) {
         player->vel.x = PLAYER_SPEED;
         player->dir = DIRECTION_RIGHT;
     } else {
@@ -47,7 +51,7 @@ void player_update(float dt)
     }
 
     if (input_is_key_pressed(&state->input.kb, KB_W) ||
-        input_gamepad_button_pressed(3, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)) {
+        input_is_pad_pressed(&state->input.pad, GAMEPAD_BUTTON_RIGHT_FACE_DOWN)) {
         if (player->on_ground) {
             player->vel.y -= PLAYER_JUMP_STRENGTH;
             player->on_ground = false;
@@ -55,20 +59,17 @@ void player_update(float dt)
     }
 
     if (input_is_key_pressed(&state->input.kb, KB_SPACE) ||
-        input_gamepad_button_pressed(3, GAMEPAD_BUTTON_RIGHT_FACE_LEFT)) {
-        bullets[n_bullets] = (Bullet){
-            .pos = player->pos,
-            .dir = player->dir,
-        };
-        live_bullets[n_live_bullets++] = n_bullets;
-        n_bullets++;
-    }
-
-    for (size_t i = 0; i < n_live_bullets; ++i) {
-        Bullet* b = &bullets[live_bullets[i]];
-        b->pos.x += BULLET_VELOCITY * (f32)b->dir * dt;
-
-        // TODO: bullet collision with blocks and off screen
+        input_is_pad_pressed(&state->input.pad, GAMEPAD_BUTTON_RIGHT_FACE_LEFT)) {
+        projectiles_spawn(
+            (Vector2){
+                .x = player->pos.x + player->size.x * 0.5f,
+                .y = player->pos.y + player->size.y * 0.5f,
+            },
+            (Vector2){
+                .x = BULLET_VELOCITY * (f32)player->dir,
+                .y = 0.0f,
+            },
+            0.0f);
     }
 
     player->vel.y += GRAVITY * dt;
@@ -79,7 +80,7 @@ void player_update(float dt)
 
     // If player falls beyond map bottom
     if (new_y >= tm->tiles_high * tm->tile_size) {
-        SetGamepadVibration(3, 10.0f, 10.0f, 0.5f);
+        SetGamepadVibration(INPUT_GAMEPAD, 10.0f, 10.0f, 0.5f);
         state->state = GAME_STATE_GAME_OVER;
     }
 
@@ -92,30 +93,16 @@ void player_update(float dt)
             .height = player->size.y,
         };
 
-        size_t first, last;
-        get_overlapping_tiles(horz_box, &first, &last);
-
-        // TODO: fix the first and last not being correct
-        // for (size_t i = first; i <= last; ++i) {
-        for (size_t i = 0; i < MAX_NUM_TILES; ++i) {
-            Tile* tile = &tm->tiles[i];
-            if (!tile->solid) {
-                continue;
-            }
-
-            if (CheckCollisionRecs(horz_box, tile->dst)) {
-                util_debug("collisios");
-
-                if (player->vel.x > 0) {
-                    // Resolve to the right
-                    new_x = tile->dst.x - player->size.x - 0.001f;
-                } else {
-                    // Resolve to the left
-                    new_x = tile->dst.x + tile->dst.width + 0.001f;
-                }
-                player->vel.x = 0.0f;
-                break;
+        Rectangle tile;
+        if (sweep_x(tm, horz_box, player->vel.x > 0, &tile)) {
+            if (player->vel.x > 0) {
+                // Resolve to the right
+                new_x = tile.x - player->size.x - 0.001f;
+            } else {
+                // Resolve to the left
+                new_x = tile.x + tile.width + 0.001f;
             }
+            player->vel.x = 0.0f;
         }
     }
 
@@ -128,29 +115,19 @@ void player_update(float dt)
             .height = fabsf(player->vel.y * dt),
         };
 
-        size_t first, last;
-        get_overlapping_tiles(vert_box, &first, &last);
-
         player->on_ground = false;
 
-        // TODO: fix the first and last not being correct
-        // for (size_t i = first; i <= last; ++i) {
-        for (size_t i = 0; i < MAX_NUM_TILES; ++i) {
-            Tile* tile = &tm->tiles[i];
-            if (!tile->solid) continue;
-
-            if (CheckCollisionRecs(vert_box, tile->dst)) {
-                if (player->vel.y > 0) {
-                    // Player is falling
-                    new_y = tile->dst.y - player->size.y - 0.001f;
-                    player->on_ground = true;
-                } else {
-                    // Player is moving up/jumping
-                    new_y = tile->dst.y + tile->dst.height + 0.001f;
-                }
-                player->vel.y = 0.0f;
-                break;
+        Rectangle tile;
+        if (sweep_y(tm, vert_box, player->vel.y > 0, &tile)) {
+            if (player->vel.y > 0) {
+                // Player is falling
+                new_y = tile.y - player->size.y - 0.001f;
+                player->on_ground = true;
+            } else {
+                // Player is moving up/jumping
+                new_y = tile.y + tile.height + 0.001f;
             }
+            player->vel.y = 0.0f;
         }
     }
 
@@ -172,6 +149,7 @@ void player_reset(Player* player)
 
     *player = (Player){
         .pos = player_wpos,
+        .prev_pos = player_wpos,
         .size =
             {
                 .x = 18,
@@ -181,17 +159,25 @@ void player_reset(Player* player)
     };
 }
 
+// The player's position blended between the last two simulation steps.
+Vector2 player_get_render_pos(void)
+{
+    return lerpv(player->prev_pos, player->pos, state->sim_alpha);
+}
+
 void player_render(void)
 {
+    Vector2 pos = player_get_render_pos();
+
     // Scale added for size in player creation and in update for pos
-    DrawRectangleRec(
-        (Rectangle){
-            .x = player->pos.x,
-            .y = player->pos.y,
-            .width = player->size.x,
-            .height = player->size.y,
-        },
-        GREEN);
+    draw_rect(DRAW_LAYER_ENTITIES,
+              (Rectangle){
+                  .x = pos.x,
+                  .y = pos.y,
+                  .width = player->size.x,
+                  .height = player->size.y,
+              },
+              GREEN);
 
     // --------------------------------------------------------------------------------------------
     // TODO: debug overlap
@@ -204,42 +190,76 @@ void player_render(void)
         .width = fabsf(player->vel.x * dt),
         .height = player->size.y,
     };
-    DrawRectangleRec(horz_box, RED);
-
-    size_t first, last;
-    get_overlapping_tiles(horz_box, &first, &last);
-
-    for (size_t i = 0; i < n_live_bullets; ++i) {
-        Bullet b = bullets[live_bullets[i]];
-        u16 y = (u16)(b.pos.y + player->size.y * 0.5f);
-
-        DrawLineEx((Vector2){b.pos.x, y},
-                   (Vector2){
-                       b.pos.x + 5.0f,
-                       y,
-                   },
-                   5.0f,
-                   PALEBLUE_D);
+    draw_rect(DRAW_LAYER_ENTITIES, horz_box, RED);
+
+    if (state->debug) {
+        Tilemap* tm = &state->active_level->tilemap;
+        TileSpan span = tilemap_get_overlapping_tiles(tm, horz_box);
+        for (u16 row = span.row_start; row < span.row_end; ++row) {
+            for (u16 col = span.col_start; col < span.col_end; ++col) {
+                draw_rect_lines(DRAW_LAYER_WORLD_LINES,
+                                (Rectangle){
+                                    .x = (f32)(col * tm->tile_size),
+                                    .y = (f32)(row * tm->tile_size),
+                                    .width = tm->tile_size,
+                                    .height = tm->tile_size,
+                                },
+                                1.0f / state->camera.zoom,
+                                RED);
+            }
+        }
     }
 }
 
 // ································································································
 
-static inline void get_overlapping_tiles(Rectangle r, size_t* out_first, size_t* out_last)
+// Finds the nearest solid tile overlapping box, scanning columns in the direction of travel.
+static bool sweep_x(Tilemap* tm, const Rectangle box, const bool moving_right, Rectangle* out_hit)
+{
+    TileSpan span = tilemap_get_overlapping_tiles(tm, box);
+    i32 hit_col = -1;
+
+    for (u16 row = span.row_start; row < span.row_end; ++row) {
+        state->stats.tiles_tested += (u32)(span.col_end - span.col_start);
+
+        i32 col = tilemap_find_solid(tm, row, span.col_start, span.col_end, !moving_right);
+        if (col < 0) {
+            continue;
+        }
+        if (hit_col < 0 || (moving_right ? col < hit_col : col > hit_col)) {
+            hit_col = col;
+        }
+    }
+
+    if (hit_col < 0) {
+        return false;
+    }
+
+    *out_hit = tilemap_get_tile_dst(tm, (u16)hit_col, span.row_start);
+    return true;
+}
+
+// Finds the nearest solid tile overlapping box, scanning rows in the direction of travel.
+static bool sweep_y(Tilemap* tm, const Rectangle box, const bool moving_down, Rectangle* out_hit)
+{
+    TileSpan span = tilemap_get_overlapping_tiles(tm, box);
+    u16 n_rows = (u16)(span.row_end - span.row_start);
+
+    for (u16 i = 0; i < n_rows; ++i) {
+        u16 row = moving_down ? (u16)(span.row_start + i) : (u16)(span.row_end - 1 - i);
+        state->stats.tiles_tested += (u32)(span.col_end - span.col_start);
+
+        i32 col = tilemap_find_solid(tm, row, span.col_start, span.col_end, false);
+        if (col >= 0) {
+            *out_hit = tilemap_get_tile_dst(tm, (u16)col, row);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline Vector2 lerpv(const Vector2 a, const Vector2 b, const f32 t)
 {
-    // Clamp to map bounds
-    int col_start = (int)floorf(r.x / MAP_TILE_SIZE);
-    int row_start = (int)floorf(r.y / MAP_TILE_SIZE);
-    int col_end = (int)ceilf((r.x + r.width) / MAP_TILE_SIZE);
-    int row_end = (int)ceilf((r.y + r.height) / MAP_TILE_SIZE);
-
-    // Clamp to legal indices
-    if (col_start < 0) col_start = 0;
-    if (row_start < 0) row_start = 0;
-    if (col_end > MAP_COL_TILES) col_end = MAP_COL_TILES;
-    if (row_end > MAP_ROW_TILES) row_end = MAP_ROW_TILES;
-
-    // Convert the 2‑D region to a 1‑D range (row‑major)
-    *out_first = (size_t)(row_start * MAP_COL_TILES + col_start);
-    *out_last = (size_t)((row_end * MAP_COL_TILES + col_end) - 1);
+    return (Vector2){lerpf(a.x, b.x, t), lerpf(a.y, b.y, t)};
 }
@@ -6,7 +6,6 @@
 #include "utils.h"
 #include <raylib.h>
 
-#define MAX_BULLETS 50
 #define BULLET_VELOCITY 100.0f
 
 typedef enum {
@@ -18,6 +17,7 @@ typedef enum {
 typedef struct {
     Rectangle src;
     Vector2 pos;
+    Vector2 prev_pos;
     Vector2 size;
     Vector2 vel;
     Texture2D* texture;
@@ -25,14 +25,10 @@ typedef struct {
     bool on_ground;
 } Player;
 
-typedef struct {
-    Vector2 pos;
-    Direction dir;
-} Bullet;
-
 bool player_new(MemoryArena* level_mem, GameState* game_state);
 void player_update(const f32 dt);
 void player_render(void);
 void player_reset(Player* player);
+Vector2 player_get_render_pos(void);
 
 #endif // !PLAYER_H_
@@ -0,0 +1,150 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+// Fixed-capacity pool of fixed-size objects carved out of a MemoryArena. Free slots are threaded into a
+// free list through their own storage, and live slots are also tracked in a dense array so iteration
+// only touches live objects. Handles carry a generation so a handle to a freed slot is detected as
+// stale rather than aliasing whatever was allocated there next. Generation 0 is never issued, so a zeroed
+// PoolHandle is always invalid.
+
+#include "arena.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define POOL_NONE UINT32_MAX
+
+typedef struct {
+    u32 index;
+    u32 generation;
+} PoolHandle;
+
+typedef struct {
+    unsigned char* slots;
+    size_t stride;
+    u32* generations;
+    u32* dense;     // Slot indices of live objects, packed in [0, count)
+    u32* dense_pos; // Position of each live slot in dense
+    u32 free_head;
+    u32 count;
+    u32 cap;
+} Pool;
+
+#define pool_init_typed(pool, arena, T, cap) pool_init((pool), (arena), sizeof(T), _Alignof(T), (cap))
+
+static inline void* pool_slot(const Pool* pool, const u32 index)
+{
+    return pool->slots + (size_t)index * pool->stride;
+}
+
+static inline bool pool_init(Pool* pool, MemoryArena* arena, size_t elem_size, size_t align, const u32 cap)
+{
+    *pool = (Pool){0};
+
+    // Free slots hold the index of the next free slot
+    if (elem_size < sizeof(u32)) elem_size = sizeof(u32);
+    if (align < _Alignof(u32)) align = _Alignof(u32);
+    pool->stride = align_forward(elem_size, align);
+
+    pool->slots = (unsigned char*)arena_alloc_tagged(arena, pool->stride * cap, align, "Pool slots");
+    pool->generations = (u32*)arena_alloc_tagged(arena, sizeof(u32) * cap, _Alignof(u32), "Pool meta");
+    pool->dense = (u32*)arena_alloc_tagged(arena, sizeof(u32) * cap, _Alignof(u32), "Pool meta");
+    pool->dense_pos = (u32*)arena_alloc_tagged(arena, sizeof(u32) * cap, _Alignof(u32), "Pool meta");
+    if (!pool->slots || !pool->generations || !pool->dense || !pool->dense_pos) {
+        util_error("Failed to allocate pool: cap=%u, stride=%zu", cap, pool->stride);
+        return false;
+    }
+
+    pool->cap = cap;
+    for (u32 i = 0; i < cap; ++i) {
+        pool->generations[i] = 1;
+        pool->dense_pos[i] = POOL_NONE;
+        *(u32*)pool_slot(pool, i) = i + 1 < cap ? i + 1 : POOL_NONE;
+    }
+    pool->free_head = cap > 0 ? 0 : POOL_NONE;
+
+    return true;
+}
+
+// Takes a slot off the free list. Returns NULL when the pool is full; the slot's contents are undefined.
+static inline void* pool_alloc(Pool* pool, PoolHandle* out_handle)
+{
+    u32 index = pool->free_head;
+    if (index == POOL_NONE) {
+        return NULL;
+    }
+
+    void* slot = pool_slot(pool, index);
+    pool->free_head = *(u32*)slot;
+
+    pool->dense[pool->count] = index;
+    pool->dense_pos[index] = pool->count;
+    pool->count++;
+
+    if (out_handle) {
+        *out_handle = (PoolHandle){
+            .index = index,
+            .generation = pool->generations[index],
+        };
+    }
+
+    return slot;
+}
+
+// Returns the object behind handle, or NULL if it has been freed since the handle was issued or was never
+// issued at all.
+static inline void* pool_get(const Pool* pool, const PoolHandle handle)
+{
+    u32 index = handle.index;
+    if (index >= pool->cap || handle.generation == 0 || pool->generations[index] != handle.generation) {
+        return NULL;
+    }
+
+    // dense_pos is left as it was for free slots, so check the slot is actually still in the live range
+    u32 pos = pool->dense_pos[index];
+    if (pos >= pool->count || pool->dense[pos] != index) {
+        return NULL;
+    }
+    return pool_slot(pool, index);
+}
+
+static inline bool pool_free(Pool* pool, const PoolHandle handle)
+{
+    if (!pool_get(pool, handle)) {
+        return false;
+    }
+
+    u32 index = handle.index;
+    // Skip 0 on wrap-around, it marks handles that were never issued
+    if (++pool->generations[index] == 0) {
+        pool->generations[index] = 1;
+    }
+
+    // Swap-remove from the dense array
+    u32 pos = pool->dense_pos[index];
+    u32 last = pool->dense[--pool->count];
+    pool->dense[pos] = last;
+    pool->dense_pos[last] = pos;
+
+    *(u32*)pool_slot(pool, index) = pool->free_head;
+    pool->free_head = index;
+
+    return true;
+}
+
+// The i-th live object, for i in [0, count). Freeing while iterating moves the last live object into i.
+static inline void* pool_at(const Pool* pool, const u32 i)
+{
+    return pool_slot(pool, pool->dense[i]);
+}
+
+static inline PoolHandle pool_handle_at(const Pool* pool, const u32 i)
+{
+    u32 index = pool->dense[i];
+    return (PoolHandle){
+        .index = index,
+        .generation = pool->generations[index],
+    };
+}
+
+#endif // !POOL_H_
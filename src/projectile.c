@@ -0,0 +1,119 @@
+#include "projectile.h"
+#include "arena.h"
+#include "draw_list.h"
+#include "gfx.h"
+#include "level.h"
+#include "raylib.h"
+#include "state.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <string.h>
+
+static GameState* state;
+static ProjectilePool pool;
+
+static bool hits_tile(const Tilemap* tm, const u32 idx);
+
+bool projectiles_init(MemoryArena* level_mem, GameState* game_state, const u32 cap)
+{
+    state = game_state;
+
+    u32 padded_cap = projectile_padded_cap(cap);
+    f32** lanes[] = {
+        &pool.x, &pool.y, &pool.prev_x, &pool.prev_y, &pool.vx, &pool.vy, &pool.gravity, &pool.ttl,
+    };
+    for (size_t i = 0; i < sizeof(lanes) / sizeof(lanes[0]); ++i) {
+        *lanes[i] = (f32*)arena_alloc_tagged(level_mem, sizeof(f32) * padded_cap, PROJECTILE_ALIGN, "Projectiles");
+        if (!*lanes[i]) {
+            util_error("Failed to allocate for projectile pool");
+            return false;
+        }
+        memset(*lanes[i], 0, sizeof(f32) * padded_cap);
+    }
+    pool.cap = cap;
+    pool.count = 0;
+
+    return true;
+}
+
+bool projectiles_spawn(const Vector2 pos, const Vector2 vel, const f32 gravity)
+{
+    if (pool.count >= pool.cap) {
+        return false;
+    }
+
+    u32 i = pool.count++;
+    pool.x[i] = pos.x;
+    pool.y[i] = pos.y;
+    pool.prev_x[i] = pos.x;
+    pool.prev_y[i] = pos.y;
+    pool.vx[i] = vel.x;
+    pool.vy[i] = vel.y;
+    pool.gravity[i] = gravity;
+    pool.ttl[i] = PROJECTILE_TTL;
+
+    return true;
+}
+
+void projectiles_update(const f32 dt)
+{
+    Tilemap* tm = &state->active_level->tilemap;
+    Rectangle map = {
+        .width = (f32)(tm->tiles_wide * tm->tile_size),
+        .height = (f32)(tm->tiles_high * tm->tile_size),
+    };
+    Rectangle view = camera_get_view_rect(&state->camera, (f32)GetScreenWidth(), (f32)GetScreenHeight());
+
+    projectile_integrate_simd(&pool, dt);
+
+    // Walk backwards so a swap-remove never skips the projectile moved into the current slot
+    for (u32 i = pool.count; i-- > 0;) {
+        Vector2 pos = {pool.x[i], pool.y[i]};
+
+        if (pool.ttl[i] <= 0.0f || !CheckCollisionPointRec(pos, map) || !CheckCollisionPointRec(pos, view) ||
+            hits_tile(tm, i)) {
+            projectile_swap_remove(&pool, i);
+        }
+    }
+}
+
+void projectiles_render(void)
+{
+    state->stats.projectiles_live = pool.count;
+
+    for (u32 i = 0; i < pool.count; ++i) {
+        Vector2 pos = {
+            .x = lerpf(pool.prev_x[i], pool.x[i], state->sim_alpha),
+            .y = lerpf(pool.prev_y[i], pool.y[i], state->sim_alpha),
+        };
+
+        draw_line(DRAW_LAYER_ENTITIES, pos, (Vector2){pos.x + PROJECTILE_SIZE, pos.y}, PROJECTILE_SIZE, PALEBLUE_D);
+    }
+}
+
+// ································································································
+
+// Tests the cells swept between the projectile's last two positions, so fast projectiles can't tunnel.
+static bool hits_tile(const Tilemap* tm, const u32 idx)
+{
+    f32 x = pool.x[idx];
+    f32 y = pool.y[idx];
+    f32 px = pool.prev_x[idx];
+    f32 py = pool.prev_y[idx];
+
+    Rectangle swept = {
+        .x = fminf(px, x),
+        .y = fminf(py, y) - PROJECTILE_SIZE * 0.5f,
+        .width = fabsf(x - px) + PROJECTILE_SIZE,
+        .height = fabsf(y - py) + PROJECTILE_SIZE,
+    };
+    TileSpan span = tilemap_get_overlapping_tiles(tm, swept);
+
+    for (u16 row = span.row_start; row < span.row_end; ++row) {
+        if (tilemap_find_solid(tm, row, span.col_start, span.col_end, false) >= 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,26 @@
+#ifndef PROJECTILE_H_
+#define PROJECTILE_H_
+
+#include "arena.h"
+#include "projectile_kernel.h"
+#include "raylib.h"
+#include "state.h"
+#include "utils.h"
+#include <stdbool.h>
+
+#ifndef MAX_PROJECTILES
+#define MAX_PROJECTILES 1024
+#endif
+
+#define PROJECTILE_SIZE 5.0f
+#define PROJECTILE_TTL 3.0f
+
+// Live projectiles are kept packed in lanes [0, count); despawning swaps the last live one into the hole.
+typedef ProjectileSoA ProjectilePool;
+
+bool projectiles_init(MemoryArena* level_mem, GameState* game_state, const u32 cap);
+bool projectiles_spawn(const Vector2 pos, const Vector2 vel, const f32 gravity);
+void projectiles_update(const f32 dt);
+void projectiles_render(void);
+
+#endif // !PROJECTILE_H_
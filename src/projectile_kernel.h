@@ -0,0 +1,107 @@
+#ifndef PROJECTILE_KERNEL_H_
+#define PROJECTILE_KERNEL_H_
+
+// Structure-of-arrays projectile storage and the integration kernels that run over it. Kept free of
+// raylib so the kernels can be benchmarked on their own (see bench/projectile_bench.c).
+
+#include "utils.h"
+#include <stdbool.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PROJECTILE_SIMD_WIDTH 8
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PROJECTILE_SIMD_WIDTH 4
+#else
+#define PROJECTILE_SIMD_WIDTH 1
+#endif
+
+// Every array's capacity is padded to this many lanes, and aligned to this many bytes, so the SIMD
+// kernels can run over whole registers without a scalar tail.
+#define PROJECTILE_LANE_PAD 8
+#define PROJECTILE_ALIGN 32
+
+typedef struct {
+    f32* x;
+    f32* y;
+    f32* prev_x;
+    f32* prev_y;
+    f32* vx;
+    f32* vy;
+    f32* gravity;
+    f32* ttl;
+    u32 count;
+    u32 cap;
+} ProjectileSoA;
+
+static inline u32 projectile_padded_cap(const u32 cap)
+{
+    return (cap + PROJECTILE_LANE_PAD - 1) / PROJECTILE_LANE_PAD * PROJECTILE_LANE_PAD;
+}
+
+// Integrates lanes [0, count) with semi-implicit Euler: gravity feeds vy before position is advanced.
+static inline void projectile_integrate_scalar(ProjectileSoA* p, const f32 dt)
+{
+    for (u32 i = 0; i < p->count; ++i) {
+        p->prev_x[i] = p->x[i];
+        p->prev_y[i] = p->y[i];
+        p->vy[i] += p->gravity[i] * dt;
+        p->x[i] += p->vx[i] * dt;
+        p->y[i] += p->vy[i] * dt;
+        p->ttl[i] -= dt;
+    }
+}
+
+// Same as projectile_integrate_scalar, one register of lanes at a time. Lanes past count up to the
+// padded capacity are integrated too; they hold dead data and are never read back.
+static inline void projectile_integrate_simd(ProjectileSoA* p, const f32 dt)
+{
+#if PROJECTILE_SIMD_WIDTH == 8
+    __m256 vdt = _mm256_set1_ps(dt);
+    for (u32 i = 0; i < p->count; i += 8) {
+        __m256 x = _mm256_load_ps(&p->x[i]);
+        __m256 y = _mm256_load_ps(&p->y[i]);
+        __m256 vy = _mm256_add_ps(_mm256_load_ps(&p->vy[i]), _mm256_mul_ps(_mm256_load_ps(&p->gravity[i]), vdt));
+
+        _mm256_store_ps(&p->prev_x[i], x);
+        _mm256_store_ps(&p->prev_y[i], y);
+        _mm256_store_ps(&p->vy[i], vy);
+        _mm256_store_ps(&p->x[i], _mm256_add_ps(x, _mm256_mul_ps(_mm256_load_ps(&p->vx[i]), vdt)));
+        _mm256_store_ps(&p->y[i], _mm256_add_ps(y, _mm256_mul_ps(vy, vdt)));
+        _mm256_store_ps(&p->ttl[i], _mm256_sub_ps(_mm256_load_ps(&p->ttl[i]), vdt));
+    }
+#elif PROJECTILE_SIMD_WIDTH == 4
+    __m128 vdt = _mm_set1_ps(dt);
+    for (u32 i = 0; i < p->count; i += 4) {
+        __m128 x = _mm_load_ps(&p->x[i]);
+        __m128 y = _mm_load_ps(&p->y[i]);
+        __m128 vy = _mm_add_ps(_mm_load_ps(&p->vy[i]), _mm_mul_ps(_mm_load_ps(&p->gravity[i]), vdt));
+
+        _mm_store_ps(&p->prev_x[i], x);
+        _mm_store_ps(&p->prev_y[i], y);
+        _mm_store_ps(&p->vy[i], vy);
+        _mm_store_ps(&p->x[i], _mm_add_ps(x, _mm_mul_ps(_mm_load_ps(&p->vx[i]), vdt)));
+        _mm_store_ps(&p->y[i], _mm_add_ps(y, _mm_mul_ps(vy, vdt)));
+        _mm_store_ps(&p->ttl[i], _mm_sub_ps(_mm_load_ps(&p->ttl[i]), vdt));
+    }
+#else
+    projectile_integrate_scalar(p, dt);
+#endif
+}
+
+// Moves the last live projectile into slot idx.
+static inline void projectile_swap_remove(ProjectileSoA* p, const u32 idx)
+{
+    u32 last = --p->count;
+    p->x[idx] = p->x[last];
+    p->y[idx] = p->y[last];
+    p->prev_x[idx] = p->prev_x[last];
+    p->prev_y[idx] = p->prev_y[last];
+    p->vx[idx] = p->vx[last];
+    p->vy[idx] = p->vy[last];
+    p->gravity[idx] = p->gravity[last];
+    p->ttl[idx] = p->ttl[last];
+}
+
+#endif // !PROJECTILE_KERNEL_H_
@@ -1,13 +1,19 @@
 #ifndef STATE_H_
 #define STATE_H_
 
+#include "arena.h"
+#include "asset_manager.h"
 #include "input.h"
 #include "raylib.h"
+#include "utils.h"
 #include <stdbool.h>
 
 #define WINDOW_WIDTH 1980
 #define WINDOW_HEIGHT 1080
 
+#define ARENA_STATS_FILE "arena_stats.txt"
+#define FRAME_MEM_SIZE (64 * MB)
+
 #define GRAVITY 600.0f
 #define DRAG_COEF 0.0015f
 #define TERMINAL_VELOCITY sqrtf(GRAVITY / DRAG_COEF)
@@ -15,6 +21,10 @@
 #define PLAYER_SPEED 100.0f
 #define PLAYER_JUMP_STRENGTH 250.0f
 
+#define SIM_HZ 120
+#define SIM_DT (1.0f / SIM_HZ)
+#define SIM_MAX_FRAME_TIME 0.25f
+
 #define MOUSE_ROTATION_DAMPNING 0.025f
 
 #define JUMP_SPEED 10.0f
@@ -28,11 +38,32 @@ typedef enum {
 
 typedef struct Level Level;
 
+// Per-frame counters shown in the debug overlay, reset at the top of every frame. Some, like tiles_tested,
+// are only counted in update, which runs after the overlay is drawn, so the overlay reads prev_stats.
+typedef struct {
+    u32 tiles_tested;
+    u32 projectiles_live;
+    u32 chunks_drawn;
+    u32 chunks_baked;
+    u32 chunks_resident;
+    u32 draw_cmds;
+    u32 draw_calls;       // Runs of one texture in flushed draw lists, see draw_list_flush
+    u32 texture_switches;
+} FrameStats;
+
 typedef struct GameState {
     Input input;
     State state;
     Camera2D camera;
     Level* active_level;
+    MemoryArena* game_mem;
+    FontHandle ui_font;
+    MemoryArena* level_mem;
+    MemoryArena frame_mem; // Scratch memory, rewound at the top of every frame
+    FrameStats stats;
+    FrameStats prev_stats; // Last complete frame, as update runs after the overlay is drawn
+    f32 sim_accumulator;
+    f32 sim_alpha; // How far rendering is between the previous and current simulation step
     bool ui_hovered;
     bool is_running;
     bool debug;
@@ -0,0 +1,170 @@
+// Kept out of thread.h so the platform headers don't leak into files that include raylib.
+#define _DEFAULT_SOURCE
+
+#include "thread.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE NativeThread;
+typedef CRITICAL_SECTION NativeMutex;
+typedef CONDITION_VARIABLE NativeCond;
+#else
+#include <pthread.h>
+typedef pthread_t NativeThread;
+typedef pthread_mutex_t NativeMutex;
+typedef pthread_cond_t NativeCond;
+#endif
+
+_Static_assert(sizeof(NativeThread) <= sizeof(Thread), "Thread storage too small");
+_Static_assert(sizeof(NativeMutex) <= sizeof(Mutex), "Mutex storage too small");
+_Static_assert(sizeof(NativeCond) <= sizeof(CondVar), "CondVar storage too small");
+
+typedef struct {
+    ThreadFn fn;
+    void* arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID p);
+#else
+static void* thread_entry(void* p);
+#endif
+
+bool thread_start(Thread* t, ThreadFn fn, void* arg)
+{
+    // Freed by the new thread once it has picked up fn and arg
+    ThreadStart* start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    if (!start) {
+        return false;
+    }
+    *start = (ThreadStart){.fn = fn, .arg = arg};
+
+#ifdef _WIN32
+    HANDLE h = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (!h) {
+        free(start);
+        return false;
+    }
+    *(NativeThread*)t->opaque = h;
+#else
+    if (pthread_create((NativeThread*)t->opaque, NULL, thread_entry, start) != 0) {
+        free(start);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void thread_join(Thread* t)
+{
+#ifdef _WIN32
+    WaitForSingleObject(*(NativeThread*)t->opaque, INFINITE);
+    CloseHandle(*(NativeThread*)t->opaque);
+#else
+    pthread_join(*(NativeThread*)t->opaque, NULL);
+#endif
+}
+
+void mutex_init(Mutex* m)
+{
+#ifdef _WIN32
+    InitializeCriticalSection((NativeMutex*)m->opaque);
+#else
+    pthread_mutex_init((NativeMutex*)m->opaque, NULL);
+#endif
+}
+
+void mutex_lock(Mutex* m)
+{
+#ifdef _WIN32
+    EnterCriticalSection((NativeMutex*)m->opaque);
+#else
+    pthread_mutex_lock((NativeMutex*)m->opaque);
+#endif
+}
+
+void mutex_unlock(Mutex* m)
+{
+#ifdef _WIN32
+    LeaveCriticalSection((NativeMutex*)m->opaque);
+#else
+    pthread_mutex_unlock((NativeMutex*)m->opaque);
+#endif
+}
+
+void mutex_destroy(Mutex* m)
+{
+#ifdef _WIN32
+    DeleteCriticalSection((NativeMutex*)m->opaque);
+#else
+    pthread_mutex_destroy((NativeMutex*)m->opaque);
+#endif
+}
+
+void cond_init(CondVar* c)
+{
+#ifdef _WIN32
+    InitializeConditionVariable((NativeCond*)c->opaque);
+#else
+    pthread_cond_init((NativeCond*)c->opaque, NULL);
+#endif
+}
+
+void cond_wait(CondVar* c, Mutex* m)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS((NativeCond*)c->opaque, (NativeMutex*)m->opaque, INFINITE);
+#else
+    pthread_cond_wait((NativeCond*)c->opaque, (NativeMutex*)m->opaque);
+#endif
+}
+
+void cond_signal(CondVar* c)
+{
+#ifdef _WIN32
+    WakeConditionVariable((NativeCond*)c->opaque);
+#else
+    pthread_cond_signal((NativeCond*)c->opaque);
+#endif
+}
+
+void cond_broadcast(CondVar* c)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable((NativeCond*)c->opaque);
+#else
+    pthread_cond_broadcast((NativeCond*)c->opaque);
+#endif
+}
+
+void cond_destroy(CondVar* c)
+{
+#ifdef _WIN32
+    (void)c;
+#else
+    pthread_cond_destroy((NativeCond*)c->opaque);
+#endif
+}
+
+// ································································································
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID p)
+#else
+static void* thread_entry(void* p)
+#endif
+{
+    ThreadStart start = *(ThreadStart*)p;
+    free(p);
+
+    start.fn(start.arg);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
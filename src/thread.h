@@ -0,0 +1,37 @@
+#ifndef THREAD_H_
+#define THREAD_H_
+
+#include "utils.h"
+#include <stdbool.h>
+
+// Thin wrappers over pthreads and Win32 threads. The platform types are stored opaquely so that this header
+// can be included alongside raylib, whose names clash with windows.h.
+typedef struct {
+    u64 opaque[1];
+} Thread;
+
+typedef struct {
+    u64 opaque[8];
+} Mutex;
+
+typedef struct {
+    u64 opaque[8];
+} CondVar;
+
+typedef void (*ThreadFn)(void* arg);
+
+bool thread_start(Thread* t, ThreadFn fn, void* arg);
+void thread_join(Thread* t);
+
+void mutex_init(Mutex* m);
+void mutex_lock(Mutex* m);
+void mutex_unlock(Mutex* m);
+void mutex_destroy(Mutex* m);
+
+void cond_init(CondVar* c);
+void cond_wait(CondVar* c, Mutex* m);
+void cond_signal(CondVar* c);
+void cond_broadcast(CondVar* c);
+void cond_destroy(CondVar* c);
+
+#endif // !THREAD_H_
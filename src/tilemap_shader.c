@@ -0,0 +1,139 @@
+#include "tilemap_shader.h"
+#include "chunk_stream.h"
+#include "raylib.h"
+#include "utils.h"
+#include <stdbool.h>
+
+#define TILEMAP_SHADER_STRINGIFY_(x) #x
+#define TILEMAP_SHADER_STRINGIFY(x) TILEMAP_SHADER_STRINGIFY_(x)
+
+// texture0 is the slot table, bound by the draw call. Its texture coordinates are in table texels, so
+// scaling them by the table size gives the position in chunks.
+static const char* fragment_src =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform sampler2D tile_ids;\n"
+    "uniform sampler2D tileset;\n"
+    "uniform int tileset_cols;\n"
+    "uniform int n_tiles;\n"
+    "uniform float tile_size;\n"
+    "out vec4 finalColor;\n"
+    "const int CHUNK_TILES = " TILEMAP_SHADER_STRINGIFY(CHUNK_TILES) ";\n"
+    "int decode(vec4 t) { return int(t.r * 255.0 + 0.5) + int(t.a * 255.0 + 0.5) * 256; }\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 pos = fragTexCoord * vec2(textureSize(texture0, 0)) * float(CHUNK_TILES);\n"
+    "    ivec2 tile = ivec2(floor(pos));\n"
+    "    ivec2 chunk = tile / CHUNK_TILES;\n"
+    "    int slot = decode(texelFetch(texture0, chunk, 0)) - 1;\n"
+    "    if (slot < 0) discard;\n"
+    "    ivec2 cell = tile - chunk * CHUNK_TILES;\n"
+    "    int id = decode(texelFetch(tile_ids, ivec2(cell.x, slot * CHUNK_TILES + cell.y), 0));\n"
+    "    if (id == 0 || id > n_tiles) discard;\n"
+    "    vec2 src = (vec2((id - 1) % tileset_cols, (id - 1) / tileset_cols) + fract(pos)) * tile_size;\n"
+    "    finalColor = texture(tileset, src / vec2(textureSize(tileset, 0))) * fragColor;\n"
+    "}\n";
+
+static Texture2D create_id_texture(const i32 width, const i32 height);
+
+// Fails if the shader doesn't compile, e.g. on GL versions without texelFetch, so the caller can fall back
+// to baking chunks.
+bool tilemap_shader_init(TilemapShader* ts,
+                         const u16 n_slots,
+                         const Texture2D* tileset,
+                         const u16 tileset_cols,
+                         const u16 n_tiles,
+                         const u16 tile_size)
+{
+    *ts = (TilemapShader){.tileset = tileset};
+
+    ts->shader = LoadShaderFromMemory(NULL, fragment_src);
+    if (!IsShaderValid(ts->shader)) {
+        util_warn("Tilemap shader is unavailable");
+        return false;
+    }
+
+    ts->tile_ids = create_id_texture(CHUNK_TILES, CHUNK_TILES * n_slots);
+    ts->slot_table = create_id_texture(TILEMAP_SHADER_MAX_WINDOW, TILEMAP_SHADER_MAX_WINDOW);
+    if (!IsTextureValid(ts->tile_ids) || !IsTextureValid(ts->slot_table)) {
+        util_error("Failed to create tilemap shader textures");
+        tilemap_shader_destroy(ts);
+        return false;
+    }
+
+    ts->loc_tile_ids = GetShaderLocation(ts->shader, "tile_ids");
+    ts->loc_tileset = GetShaderLocation(ts->shader, "tileset");
+
+    // These only change with the tileset, and uniforms keep their values between draws
+    i32 cols = tileset_cols;
+    i32 tiles = n_tiles;
+    f32 size = (f32)tile_size;
+    SetShaderValue(ts->shader, GetShaderLocation(ts->shader, "tileset_cols"), &cols, SHADER_UNIFORM_INT);
+    SetShaderValue(ts->shader, GetShaderLocation(ts->shader, "n_tiles"), &tiles, SHADER_UNIFORM_INT);
+    SetShaderValue(ts->shader, GetShaderLocation(ts->shader, "tile_size"), &size, SHADER_UNIFORM_FLOAT);
+
+    return true;
+}
+
+// Uploads every tile of the chunk now in slot.
+void tilemap_shader_upload_chunk(TilemapShader* ts, const u16 slot, const ChunkData* data)
+{
+    Rectangle rec = {0.0f, (f32)(slot * CHUNK_TILES), CHUNK_TILES, CHUNK_TILES};
+    UpdateTextureRec(ts->tile_ids, rec, data->tiles);
+}
+
+// Uploads a single edited tile; col and row are within the chunk.
+void tilemap_shader_upload_tile(TilemapShader* ts, const u16 slot, const u16 col, const u16 row, const TileId id)
+{
+    Rectangle rec = {(f32)col, (f32)(slot * CHUNK_TILES + row), 1.0f, 1.0f};
+    UpdateTextureRec(ts->tile_ids, rec, &id);
+}
+
+// Draws the cols by rows chunks whose slots have been written to ts->slots, row by row, over dst. Must be
+// called in world space.
+void tilemap_shader_draw(TilemapShader* ts, const Rectangle dst, const u16 cols, const u16 rows)
+{
+    if (cols == 0 || rows == 0) {
+        return;
+    }
+
+    Rectangle src = {0.0f, 0.0f, (f32)cols, (f32)rows};
+    UpdateTextureRec(ts->slot_table, src, ts->slots);
+
+    BeginShaderMode(ts->shader);
+    {
+        SetShaderValueTexture(ts->shader, ts->loc_tile_ids, ts->tile_ids);
+        SetShaderValueTexture(ts->shader, ts->loc_tileset, *ts->tileset);
+        DrawTexturePro(ts->slot_table, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
+    }
+    EndShaderMode();
+}
+
+void tilemap_shader_destroy(TilemapShader* ts)
+{
+    if (IsTextureValid(ts->tile_ids)) {
+        UnloadTexture(ts->tile_ids);
+    }
+    if (IsTextureValid(ts->slot_table)) {
+        UnloadTexture(ts->slot_table);
+    }
+    if (IsShaderValid(ts->shader)) {
+        UnloadShader(ts->shader);
+    }
+    *ts = (TilemapShader){0};
+}
+
+// ································································································
+
+// Two bytes per texel, zeroed, which reads as TILE_EMPTY or "not resident".
+static Texture2D create_id_texture(const i32 width, const i32 height)
+{
+    Image img = GenImageColor(width, height, BLANK);
+    ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA);
+    Texture2D tex = LoadTextureFromImage(img);
+    UnloadImage(img);
+
+    return tex;
+}
@@ -0,0 +1,37 @@
+#ifndef TILEMAP_SHADER_H_
+#define TILEMAP_SHADER_H_
+
+#include "chunk_stream.h"
+#include "raylib.h"
+#include "utils.h"
+#include <stdbool.h>
+
+// Most chunks the shader can draw at once, per axis. Anything further out is left undrawn.
+#define TILEMAP_SHADER_MAX_WINDOW 32
+
+// Draws the tilemap with a single quad. Tile IDs live on the GPU in tile_ids, one CHUNK_TILES square block
+// per chunk stream slot, and slot_table maps each chunk of the drawn window to its slot. The fragment shader
+// follows both to a tileset cell, so the cost is per pixel rather than per tile. IDs are stored as
+// GRAY_ALPHA texels holding the low and high byte, which is how a u16 lies in memory on little-endian hosts.
+typedef struct {
+    Shader shader;
+    Texture2D tile_ids;
+    Texture2D slot_table;
+    const Texture2D* tileset;
+    i32 loc_tile_ids;
+    i32 loc_tileset;
+    u16 slots[TILEMAP_SHADER_MAX_WINDOW * TILEMAP_SHADER_MAX_WINDOW]; // Staging for slot_table, slot + 1 or 0
+} TilemapShader;
+
+bool tilemap_shader_init(TilemapShader* ts,
+                         const u16 n_slots,
+                         const Texture2D* tileset,
+                         const u16 tileset_cols,
+                         const u16 n_tiles,
+                         const u16 tile_size);
+void tilemap_shader_upload_chunk(TilemapShader* ts, const u16 slot, const ChunkData* data);
+void tilemap_shader_upload_tile(TilemapShader* ts, const u16 slot, const u16 col, const u16 row, const TileId id);
+void tilemap_shader_draw(TilemapShader* ts, const Rectangle dst, const u16 cols, const u16 rows);
+void tilemap_shader_destroy(TilemapShader* ts);
+
+#endif // !TILEMAP_SHADER_H_
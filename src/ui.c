@@ -1,7 +1,9 @@
 #include "ui.h"
 #include "asset_manager.h"
+#include "draw_list.h"
 #include "gfx.h"
 #include "level.h"
+#include "projectile.h"
 #include "raylib.h"
 #define RAYGUI_IMPLEMENTATION
 // #include "raygui/floating_window.h"
@@ -10,10 +12,36 @@
 
 static GameState* state;
 
-void ui_init(GameState* game_state)
+// FontAwesome glyphs for the editor's toolbar actions. The text font needs nothing beyond printable ASCII.
+static i32 icon_codepoints[] = {
+    0xF0C7, // floppy-disk
+    0xF07C, // folder-open
+    0xF1F8, // trash
+    0xF1B8, // recycle
+    0xF2F9, // rotate-right
+    0xF52B, // door-open
+};
+
+static f32 render_arena_stats(Font* font, const char* name, const MemoryArena* arena, f32 y);
+
+bool ui_init(GameState* game_state)
 {
     state = game_state;
     // GuiLoadStyle("assets/styles/light.rgs");
+
+    state->ui_font = assetmgr_load_font(UI_TEXT_FONT, "main", UI_FONT_BAKE_SIZE, NULL, 0);
+    if (state->ui_font == ASSET_NONE) {
+        util_error("Failed to load UI font");
+        return false;
+    }
+
+    i32 n_icons = (i32)(sizeof(icon_codepoints) / sizeof(icon_codepoints[0]));
+    if (assetmgr_load_font(UI_ICON_FONT, "emoji", UI_FONT_BAKE_SIZE, icon_codepoints, n_icons) == ASSET_NONE) {
+        util_error("Failed to load UI icon font");
+        return false;
+    }
+
+    return true;
 }
 
 bool ui_is_hovering(const Vector2 p, Rectangle r)
@@ -29,26 +57,67 @@ void ui_render_debug_ui(GameState* state)
 {
     Tilemap* tm = &state->active_level->tilemap;
     // u32 map_w = tm->tiles_wide * tm->tile_size;
-    Font* font = assetmgr_get_font("main");
-
-    DrawTextEx(*font,
-               TextFormat("Zoom: x%.2f", state->camera.zoom),
-               (Vector2){10.0f, 10.0f},
-               UI_DEBUG_FONT_SIZE,
-               1.0f,
-               PALEBLUE_D);
-    DrawTextEx(*font,
-               TextFormat("STATE: %s", state->state == GAME_STATE_PLAYING ? "playing" : "editing"),
-               (Vector2){10.0f, 25.0f},
-               UI_DEBUG_FONT_SIZE,
-               1.0f,
-               PALEBLUE_D);
-    DrawTextEx(*font,
-               TextFormat("ui_active: %s [%d]", state->ui_hovered ? "true" : "false", state->ui_hovered),
-               (Vector2){10.0f, 40.0f},
-               UI_DEBUG_FONT_SIZE,
-               1.0f,
-               PALEBLUE_D);
+    Font* font = assetmgr_get_font(state->ui_font);
+
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("Zoom: x%.2f", state->camera.zoom),
+              (Vector2){10.0f, 10.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("STATE: %s", state->state == GAME_STATE_PLAYING ? "playing" : "editing"),
+              (Vector2){10.0f, 25.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("ui_active: %s [%d]", state->ui_hovered ? "true" : "false", state->ui_hovered),
+              (Vector2){10.0f, 40.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("tiles_tested: %u chunks_drawn: %u chunks_baked: %u renderer: %s [F5]",
+                         state->prev_stats.tiles_tested,
+                         state->prev_stats.chunks_drawn,
+                         state->prev_stats.chunks_baked,
+                         state->active_level->tilemap.renderer == TILEMAP_RENDER_SHADER ? "shader" : "chunks"),
+              (Vector2){10.0f, 55.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("projectiles: %u / %u chunks_resident: %u / %u",
+                         state->prev_stats.projectiles_live,
+                         MAX_PROJECTILES,
+                         state->prev_stats.chunks_resident,
+                         CHUNK_STREAM_SLOTS),
+              (Vector2){10.0f, 70.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("draw_cmds: %u draw_calls: %u texture_switches: %u",
+                         state->prev_stats.draw_cmds,
+                         state->prev_stats.draw_calls,
+                         state->prev_stats.texture_switches),
+              (Vector2){10.0f, 85.0f},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+
+    f32 y = 110.0f;
+    y = render_arena_stats(font, "game_mem", state->game_mem, y);
+    y = render_arena_stats(font, "level_mem", state->level_mem, y + 10.0f);
+    render_arena_stats(font, "frame_mem", &state->frame_mem, y + 10.0f);
 
     Vector2 mpos = GetMousePosition();
 
@@ -61,30 +130,38 @@ void ui_render_debug_ui(GameState* state)
         renpos.y += 85;
     }
 
-    DrawTextEx(*font, TextFormat("screen_pos: %.2f x %.2f", mpos.x, mpos.y), renpos, 18, 1.0f, PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("screen_pos: %.2f x %.2f", mpos.x, mpos.y),
+              renpos,
+              18,
+              1.0f,
+              PALEBLUE_D);
 
     Vector2 wpos = screenp_to_worldp(mpos, &state->camera, (f32)GetScreenWidth(), (f32)GetScreenHeight());
-    DrawTextEx(*font,
-               TextFormat("world_pos: %.2f x %.2f", wpos.x, wpos.y),
-               (Vector2){
-                   .x = renpos.x,
-                   .y = renpos.y + 20,
-               },
-               UI_TEXT_SIZE,
-               1.0f,
-               PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("world_pos: %.2f x %.2f", wpos.x, wpos.y),
+              (Vector2){
+                  .x = renpos.x,
+                  .y = renpos.y + 20,
+              },
+              UI_TEXT_SIZE,
+              1.0f,
+              PALEBLUE_D);
 
     Vector2 grid = worldp_to_gridp((Vector2){mpos.x, mpos.y}, (u8)tm->tile_size);
 
-    DrawTextEx(*font,
-               TextFormat("grid_pos: %f x %f", grid.x, grid.y),
-               (Vector2){
-                   .x = renpos.x,
-                   .y = renpos.y + 40,
-               },
-               UI_TEXT_SIZE,
-               1.0f,
-               PALEBLUE_D);
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("grid_pos: %f x %f", grid.x, grid.y),
+              (Vector2){
+                  .x = renpos.x,
+                  .y = renpos.y + 40,
+              },
+              UI_TEXT_SIZE,
+              1.0f,
+              PALEBLUE_D);
 }
 
 void ui_message_box(const char* title, const char* msg)
@@ -99,16 +176,10 @@ void ui_message_box(const char* title, const char* msg)
     GuiMessageBox(bounds, title, msg, "OK");
 }
 
-bool ui_draw_image_button(const Vector2 pos, const f32 size, const char* tex_id, const char* hint)
+bool ui_draw_image_button(const Vector2 pos, const f32 size, const TextureHandle tex_handle, const char* hint)
 {
-    Texture2D* tex = assetmgr_get_texture(tex_id);
-    if (!tex) {
-        tex = assetmgr_load_texture(tex_id);
-        if (!tex) {
-            util_error("Failed to load button texture");
-            return false;
-        }
-    }
+    // Draws as the placeholder until the texture has been decoded and uploaded
+    Texture2D* tex = assetmgr_get_texture(tex_handle);
 
     Rectangle dst = {
         .x = pos.x,
@@ -121,23 +192,26 @@ bool ui_draw_image_button(const Vector2 pos, const f32 size, const char* tex_id,
         f32 txt_len = (f32)MeasureText(hint, UI_HINT_SIZE);
         f32 x = pos.x + (size * 0.5f) - (txt_len * 0.5f);
         f32 y = pos.y + size + 10.0f;
-        DrawText(hint, (i32)x, (i32)y, UI_HINT_SIZE, PALEBLUE_D);
+        // DrawText's defaults: raylib's own font, spaced by a tenth of the size
+        Font default_font = GetFontDefault();
+        draw_text(
+            DRAW_LAYER_UI_TEXT, &default_font, hint, (Vector2){x, y}, UI_HINT_SIZE, UI_HINT_SIZE / 10.0f, PALEBLUE_D);
 
-        DrawRectangleLinesEx(dst, 2.0f, RED);
+        draw_rect_lines(DRAW_LAYER_UI_LINES, dst, 2.0f, RED);
 
         if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
             return true;
         }
     }
 
-    DrawRectangleRec(dst, (Color){0, 150, 0, 100});
+    draw_rect(DRAW_LAYER_UI_BACKGROUND, dst, (Color){0, 150, 0, 100});
 
     Rectangle src = {
         .width = (f32)tex->width,
         .height = (f32)tex->height,
     };
 
-    DrawTexturePro(*tex, src, dst, (Vector2){0}, 0.0f, WHITE);
+    draw_sprite(DRAW_LAYER_UI, tex, src, dst, WHITE);
 
     return false;
 }
@@ -160,9 +234,62 @@ bool ui_draw_button(const Vector2 pos, const Vector2 size, const Color bgcolor,
         }
     }
 
-    DrawRectangleRec(btn_rec, c);
+    draw_rect(DRAW_LAYER_UI_BACKGROUND, btn_rec, c);
 
     return false;
 }
 
 // ································································································
+
+// Renders an arena's usage and per-tag breakdown starting at y, returning the y below the last line.
+static f32 render_arena_stats(Font* font, const char* name, const MemoryArena* arena, f32 y)
+{
+    if (!arena) {
+        return y;
+    }
+
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("%s: %.1f KB used, %.1f KB committed",
+                         name,
+                         (f64)arena->offset / 1024.0,
+                         (f64)arena->committed / 1024.0),
+              (Vector2){10.0f, y},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    y += 15.0f;
+
+#if ARENA_STATS
+    const ArenaStats* st = &arena->stats;
+    draw_text(DRAW_LAYER_UI_TEXT,
+              font,
+              TextFormat("  allocs: %u peak: %.1f KB padding: %zu B",
+                         st->n_allocs,
+                         (f64)st->peak / 1024.0,
+                         st->bytes_padding),
+              (Vector2){10.0f, y},
+              UI_DEBUG_FONT_SIZE,
+              1.0f,
+              PALEBLUE_D);
+    y += 15.0f;
+
+    for (u32 i = 0; i < st->n_tags; ++i) {
+        // Format into the frame arena rather than TextFormat's shared static buffers
+        draw_text(DRAW_LAYER_UI_TEXT,
+                  font,
+                  arena_printf(&state->frame_mem,
+                               "  %s: %.1f KB [%u]",
+                               st->tags[i].tag,
+                               (f64)st->tags[i].bytes / 1024.0,
+                               st->tags[i].n_allocs),
+                  (Vector2){10.0f, y},
+                  UI_DEBUG_FONT_SIZE,
+                  1.0f,
+                  PALEBLUE_D);
+        y += 15.0f;
+    }
+#endif
+
+    return y;
+}
@@ -18,6 +18,11 @@
 
 #define UI_DEBUG_FONT_SIZE 16.0f
 
+// Fonts are rasterized once, at the largest size the UI draws at, so text is only ever scaled down
+#define UI_FONT_BAKE_SIZE ((i32)UI_HEADER_SIZE)
+#define UI_TEXT_FONT "assets/fonts/FiraCode-Regular.ttf"
+#define UI_ICON_FONT "assets/fonts/FontAwesome.ttf"
+
 typedef enum {
     ALIGN_NONE,
     ALIGN_LEFT,
@@ -35,11 +40,11 @@ typedef struct {
     bool hover;
 } MenuItem;
 
-void ui_init(GameState* game_state);
+bool ui_init(GameState* game_state);
 bool ui_is_hovering(const Vector2 p, Rectangle r);
 void ui_render_debug_ui(GameState* state);
 void ui_message_box(const char* title, const char* msg);
-bool ui_draw_image_button(const Vector2 pos, const f32 size, const char* tex_id, const char* hint);
+bool ui_draw_image_button(const Vector2 pos, const f32 size, const TextureHandle tex_handle, const char* hint);
 bool ui_draw_button(const Vector2 pos, const Vector2 size, const Color bgcolor, const Color hover_color);
 
 static inline MenuItem
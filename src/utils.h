@@ -99,4 +99,9 @@ static inline f32 clampf(f32 v, f32 lo, f32 hi)
     return fminf(fmaxf(v, lo), hi);
 }
 
+static inline f32 lerpf(f32 a, f32 b, f32 t)
+{
+    return a + (b - a) * t;
+}
+
 #endif // UTILS_H_
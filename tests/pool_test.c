@@ -0,0 +1,111 @@
+// Handle validation in pool.h: stale, zeroed and never-issued handles must be rejected without touching the
+// pool's bookkeeping.
+//
+//   make test-pool
+
+#include "arena.h"
+#include "pool.h"
+#include "utils.h"
+#include <stdlib.h>
+
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            util_error("check failed: %s", #cond);                                                                     \
+            n_failed++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+static u32 n_failed;
+
+static void test_zero_handle(void);
+static void test_double_free(void);
+static void test_never_issued(void);
+
+int main(void)
+{
+    test_zero_handle();
+    test_double_free();
+    test_never_issued();
+
+    if (n_failed > 0) {
+        util_error("%u pool checks failed", n_failed);
+        return EXIT_FAILURE;
+    }
+    util_info("pool: all checks passed");
+    return EXIT_SUCCESS;
+}
+
+// ································································································
+
+static void test_zero_handle(void)
+{
+    MemoryArena arena;
+    arena_init_virtual(&arena, 1 * MB);
+    Pool pool;
+    CHECK(pool_init_typed(&pool, &arena, u64, 8));
+
+    PoolHandle zero = {0};
+    CHECK(pool_get(&pool, zero) == NULL);
+    CHECK(!pool_free(&pool, zero));
+    CHECK(pool.count == 0);
+
+    // Slot 0 being live doesn't make the zero handle valid
+    PoolHandle h;
+    CHECK(pool_alloc(&pool, &h) != NULL);
+    CHECK(h.index == 0 && h.generation != 0);
+    CHECK(pool_get(&pool, zero) == NULL);
+    CHECK(!pool_free(&pool, zero));
+    CHECK(pool.count == 1);
+
+    arena_free(&arena);
+}
+
+static void test_double_free(void)
+{
+    MemoryArena arena;
+    arena_init_virtual(&arena, 1 * MB);
+    Pool pool;
+    CHECK(pool_init_typed(&pool, &arena, u64, 8));
+
+    PoolHandle a, b;
+    CHECK(pool_alloc(&pool, &a) != NULL);
+    CHECK(pool_alloc(&pool, &b) != NULL);
+
+    CHECK(pool_free(&pool, a));
+    CHECK(!pool_free(&pool, a));
+    CHECK(pool_get(&pool, a) == NULL);
+    CHECK(pool.count == 1);
+    CHECK(pool_get(&pool, b) != NULL);
+
+    // The reused slot gets a new generation, so the old handle stays stale
+    PoolHandle c;
+    CHECK(pool_alloc(&pool, &c) != NULL);
+    CHECK(c.index == a.index && c.generation != a.generation);
+    CHECK(pool_get(&pool, a) == NULL);
+    CHECK(!pool_free(&pool, a));
+    CHECK(pool.count == 2);
+
+    arena_free(&arena);
+}
+
+static void test_never_issued(void)
+{
+    MemoryArena arena;
+    arena_init_virtual(&arena, 1 * MB);
+    Pool pool;
+    CHECK(pool_init_typed(&pool, &arena, u64, 8));
+
+    PoolHandle live;
+    CHECK(pool_alloc(&pool, &live) != NULL);
+
+    // Right generation for a free slot, an index past the end
+    CHECK(pool_get(&pool, (PoolHandle){.index = 3, .generation = 1}) == NULL);
+    CHECK(!pool_free(&pool, (PoolHandle){.index = 3, .generation = 1}));
+    CHECK(pool_get(&pool, (PoolHandle){.index = 8, .generation = 1}) == NULL);
+    CHECK(!pool_free(&pool, (PoolHandle){.index = POOL_NONE, .generation = 1}));
+    CHECK(pool.count == 1);
+    CHECK(pool_get(&pool, live) != NULL);
+
+    arena_free(&arena);
+}
@@ -0,0 +1,190 @@
+// Packs asset directories into a single file the game can map instead of opening each asset on its own.
+// See src/asset_pack.h for the format.
+//
+//   make pack-assets
+//   pack_assets <out.pack> <dir>...
+
+#define _DEFAULT_SOURCE
+
+#include "asset_pack.h"
+#include "utils.h"
+#include <dirent.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+    AssetPackEntry* entries;
+    u32 count;
+    u32 cap;
+} EntryList;
+
+static bool collect(EntryList* list, const char* dir);
+static bool add_entry(EntryList* list, const char* path, const size_t size);
+static int compare_entries(const void* a, const void* b);
+static bool write_pack(const EntryList* list, const char* out_path);
+static bool copy_file(FILE* out, const AssetPackEntry* e);
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        util_error("Usage: %s <out.pack> <dir>...", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    EntryList list = {0};
+    for (int i = 2; i < argc; ++i) {
+        if (!collect(&list, argv[i])) {
+            free(list.entries);
+            return EXIT_FAILURE;
+        }
+    }
+
+    qsort(list.entries, list.count, sizeof(AssetPackEntry), compare_entries);
+
+    bool ok = write_pack(&list, argv[1]);
+    if (ok) {
+        util_info("Packed %u files into %s", list.count, argv[1]);
+    }
+    free(list.entries);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ································································································
+
+// Adds every regular file under dir, recursing into subdirectories.
+static bool collect(EntryList* list, const char* dir)
+{
+    DIR* d = opendir(dir);
+    if (!d) {
+        util_error("Failed to open directory: %s", dir);
+        return false;
+    }
+
+    bool ok = true;
+    struct dirent* ent;
+    while (ok && (ent = readdir(d)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        char path[ASSET_PACK_MAX_PATH];
+        int len = snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+        if (len < 0 || (size_t)len >= sizeof(path)) {
+            util_error("Asset path too long: %s/%s", dir, ent->d_name);
+            ok = false;
+            break;
+        }
+
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            util_error("Failed to stat: %s", path);
+            ok = false;
+        } else if (S_ISDIR(st.st_mode)) {
+            ok = collect(list, path);
+        } else if (S_ISREG(st.st_mode)) {
+            ok = add_entry(list, path, (size_t)st.st_size);
+        }
+    }
+
+    closedir(d);
+    return ok;
+}
+
+static bool add_entry(EntryList* list, const char* path, const size_t size)
+{
+    if (list->count == list->cap) {
+        u32 cap = list->cap ? list->cap * 2 : 64;
+        AssetPackEntry* entries = (AssetPackEntry*)realloc(list->entries, sizeof(AssetPackEntry) * cap);
+        if (!entries) {
+            util_error("Failed to grow entry list");
+            return false;
+        }
+        list->entries = entries;
+        list->cap = cap;
+    }
+
+    if (size > UINT32_MAX) {
+        util_error("Asset too large to pack: %s", path);
+        return false;
+    }
+
+    AssetPackEntry* e = &list->entries[list->count++];
+    *e = (AssetPackEntry){.size = (u32)size};
+    strncpy(e->path, path, ASSET_PACK_MAX_PATH - 1);
+
+    return true;
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+    return strcmp(((const AssetPackEntry*)a)->path, ((const AssetPackEntry*)b)->path);
+}
+
+// Lays the files out after the entry table and writes the lot. Fields are written in host byte order, so
+// packs must be built on a little-endian machine.
+static bool write_pack(const EntryList* list, const char* out_path)
+{
+    size_t offset = sizeof(AssetPackHeader) + sizeof(AssetPackEntry) * list->count;
+    for (u32 i = 0; i < list->count; ++i) {
+        offset = (offset + ASSET_PACK_ALIGN - 1) & ~(size_t)(ASSET_PACK_ALIGN - 1);
+        if (offset + list->entries[i].size > UINT32_MAX) {
+            util_error("Asset pack would be larger than 4GB");
+            return false;
+        }
+        list->entries[i].offset = (u32)offset;
+        offset += list->entries[i].size;
+    }
+
+    FILE* out = fopen(out_path, "wb");
+    if (!out) {
+        util_error("Failed to open for writing: %s", out_path);
+        return false;
+    }
+
+    AssetPackHeader header = {.magic = ASSET_PACK_MAGIC, .version = ASSET_PACK_VERSION, .n_entries = list->count};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              (list->count == 0 || fwrite(list->entries, sizeof(AssetPackEntry), list->count, out) == list->count);
+
+    for (u32 i = 0; ok && i < list->count; ++i) {
+        static const u8 zeros[ASSET_PACK_ALIGN] = {0};
+        size_t pad = list->entries[i].offset - (size_t)ftell(out);
+        ok = (pad == 0 || fwrite(zeros, 1, pad, out) == pad) && copy_file(out, &list->entries[i]);
+    }
+
+    if (fclose(out) != 0 || !ok) {
+        util_error("Failed to write asset pack: %s", out_path);
+        remove(out_path);
+        return false;
+    }
+
+    return true;
+}
+
+static bool copy_file(FILE* out, const AssetPackEntry* e)
+{
+    FILE* in = fopen(e->path, "rb");
+    if (!in) {
+        util_error("Failed to open: %s", e->path);
+        return false;
+    }
+
+    u8 buf[64 * 1024];
+    size_t remaining = e->size;
+    while (remaining > 0) {
+        size_t n = fread(buf, 1, remaining < sizeof(buf) ? remaining : sizeof(buf), in);
+        if (n == 0 || fwrite(buf, 1, n, out) != n) {
+            break;
+        }
+        remaining -= n;
+    }
+
+    fclose(in);
+    if (remaining != 0) {
+        util_error("Failed to copy: %s", e->path);
+        return false;
+    }
+
+    return true;
+}